@@ -0,0 +1,287 @@
+#include <stdlib.h>
+#include "constTime.h"
+
+
+/**
+ ** Returns 0xFFFFFFFF if the lowest bit of condition is set, else 0.
+ **/
+static uint32 CtMask(uint32 condition) {
+    return 0 - (condition & 1);
+}
+
+/**
+ ** Returns 1 if x is not zero, else 0.
+ **/
+static uint32 CtIsNonZero(uint32 x) {
+    return (x | (0 - x)) >> 31;
+}
+
+/**
+ ** Returns the number of bits up to the leftmost one bit of x.
+ **/
+static uint32 CtBitLength(uint32 x) {
+    x |= x >> 1;
+    x |= x >> 2;
+    x |= x >> 4;
+    x |= x >> 8;
+    x |= x >> 16;
+    /* population count of the smeared value */
+    x = x - ((x >> 1) & 0x55555555U);
+    x = (x & 0x33333333U) + ((x >> 2) & 0x33333333U);
+    x = (x + (x >> 4)) & 0x0F0F0F0FU;
+    return (x * 0x01010101U) >> 24;
+}
+
+/**
+ ** Returns word i of x or 0 if i is not below the word size of x.
+ **/
+static uint32 CtWord(const LargeInt* x, uint32 i) {
+    return (i < x->wordSize) ? x->data[i] : 0;
+}
+
+static void CtSelectWords(uint32* r, const uint32* a, const uint32* b, uint32 n, uint32 condition) {
+    uint32 mask = CtMask(condition);
+    uint32 i;
+    for (i = 0; i < n; i++) {
+        r[i] = (a[i] & mask) | (b[i] & ~mask);
+    }
+}
+
+static void CtSwapWords(uint32* a, uint32* b, uint32 n, uint32 condition) {
+    uint32 mask = CtMask(condition);
+    uint32 i;
+    for (i = 0; i < n; i++) {
+        uint32 t = (a[i] ^ b[i]) & mask;
+        a[i] ^= t;
+        b[i] ^= t;
+    }
+}
+
+/**
+ ** Subtracts b from a into r, all with n words, and returns the borrow.
+ **/
+static uint32 CtSubtractWords(uint32* r, const uint32* a, const uint32* b, uint32 n) {
+    uint32 borrow = 0;
+    uint32 i;
+    for (i = 0; i < n; i++) {
+        uint32 d = a[i] - b[i] - borrow;
+        borrow = d >> 31;
+        r[i] = d & STANDARD_USEBIT_MASK;
+    }
+    return borrow;
+}
+
+
+void CtSelect(LargeInt* r, const LargeInt* a, const LargeInt* b, uint32 condition) {
+    uint32 mask = CtMask(condition);
+    uint32 i;
+    for (i = 0; i < r->wordSize; i++) {
+        r->data[i] = (CtWord(a, i) & mask) | (CtWord(b, i) & ~mask);
+    }
+    CtRecomputeUsageVariables(r);
+}
+
+
+void CtSwap(LargeInt* a, LargeInt* b, uint32 condition) {
+    uint32 mask = CtMask(condition);
+    uint32 t;
+    CtSwapWords(a->data, b->data, a->wordSize, condition);
+    t = (a->usedWords ^ b->usedWords) & mask;
+    a->usedWords ^= t;
+    b->usedWords ^= t;
+    t = (a->bitSize ^ b->bitSize) & mask;
+    a->bitSize ^= t;
+    b->bitSize ^= t;
+}
+
+
+uint32 CtAdd(LargeInt* r, const LargeInt* a, const LargeInt* b) {
+    uint32 carry = 0;
+    uint32 i;
+    for (i = 0; i < r->wordSize; i++) {
+        uint32 s = CtWord(a, i) + CtWord(b, i) + carry;
+        r->data[i] = s & STANDARD_USEBIT_MASK;
+        carry = s >> BITSPERWORD;
+    }
+    CtRecomputeUsageVariables(r);
+    return carry;
+}
+
+
+uint32 CtSubtract(LargeInt* r, const LargeInt* a, const LargeInt* b) {
+    uint32 borrow = 0;
+    uint32 i;
+    for (i = 0; i < r->wordSize; i++) {
+        uint32 d = CtWord(a, i) - CtWord(b, i) - borrow;
+        borrow = d >> 31;
+        r->data[i] = d & STANDARD_USEBIT_MASK;
+    }
+    CtRecomputeUsageVariables(r);
+    return borrow;
+}
+
+
+void CtMultiply(LargeInt* r, const LargeInt* a, const LargeInt* b) {
+    uint32 i, j, s, carry;
+    for (i = 0; i < r->wordSize; i++) r->data[i] = 0;
+    for (i = 0; i < a->wordSize; i++) {
+        carry = 0;
+        for (j = 0; j < b->wordSize; j++) {
+            s = r->data[i + j] + a->data[i] * b->data[j] + carry;
+            r->data[i + j] = s & STANDARD_USEBIT_MASK;
+            carry = s >> BITSPERWORD;
+        }
+        r->data[i + j] = carry;
+    }
+    CtRecomputeUsageVariables(r);
+}
+
+
+void CtRecomputeUsageVariables(LargeInt* b) {
+    uint32 used = 0;
+    uint32 top = 0;
+    uint32 i;
+    for (i = 0; i < b->wordSize; i++) {
+        uint32 mask = CtMask(CtIsNonZero(b->data[i]));
+        used = ((i + 1) & mask) | (used & ~mask);
+        top = (b->data[i] & mask) | (top & ~mask);
+    }
+    b->usedWords = used;
+    b->bitSize = (used * BITSPERWORD - BITSPERWORD + CtBitLength(top)) & CtMask(CtIsNonZero(used));
+}
+
+
+LargeInt* CtMod(const LargeInt* a, const LargeInt* m) {
+    uint32 n = m->wordSize;
+    uint32* rest = (uint32*)calloc(n + 1, sizeof(uint32));
+    uint32* difference = (uint32*)calloc(n + 1, sizeof(uint32));
+    uint32* modulus = (uint32*)calloc(n + 1, sizeof(uint32));
+    LargeInt* ergebnis = InitLargeIntWithUint32(0, n);
+    sint32 i;
+    uint32 j;
+
+    for (j = 0; j < n; j++) modulus[j] = m->data[j];
+
+    for (i = (sint32)(a->wordSize * BITSPERWORD) - 1; i >= 0; i--) {
+        uint32 bit = (a->data[i / BITSPERWORD] >> (i % BITSPERWORD)) & 1;
+        for (j = 0; j <= n; j++) {
+            uint32 shifted = (rest[j] << 1) | bit;
+            bit = shifted >> BITSPERWORD;
+            rest[j] = shifted & STANDARD_USEBIT_MASK;
+        }
+        /* keep the difference unless it is negative */
+        CtSelectWords(rest, rest, difference, n + 1,
+                      CtSubtractWords(difference, rest, modulus, n + 1));
+    }
+
+    for (j = 0; j < n; j++) ergebnis->data[j] = rest[j];
+    CtRecomputeUsageVariables(ergebnis);
+    free(rest);
+    free(difference);
+    free(modulus);
+    return ergebnis;
+}
+
+
+/**
+ ** \brief Computes r = a * b * R^(-1) mod m without data-dependent
+ **        branches.
+ **
+ ** a, b and r hold ctx->words words each and may overlap. t and u are
+ ** scratch space of ctx->words + 2 words each.
+ **/
+static void CtMontgomeryMultiplyWords(uint32* r, const uint32* a, const uint32* b,
+                                      const MontgomeryContext* ctx, uint32* t, uint32* u) {
+    uint32 n = ctx->words;
+    const uint32* m = ctx->modulus->data;
+    uint32 i, j, s, q, carry;
+
+    for (j = 0; j < n + 2; j++) t[j] = 0;
+
+    for (i = 0; i < n; i++) {
+        carry = 0;
+        for (j = 0; j < n; j++) {
+            s = t[j] + a[i] * b[j] + carry;
+            t[j] = s & STANDARD_USEBIT_MASK;
+            carry = s >> BITSPERWORD;
+        }
+        s = t[n] + carry;
+        t[n] = s & STANDARD_USEBIT_MASK;
+        t[n + 1] = s >> BITSPERWORD;
+
+        q = (t[0] * ctx->inverse) & STANDARD_USEBIT_MASK;
+        carry = (t[0] + q * m[0]) >> BITSPERWORD;
+        for (j = 1; j < n; j++) {
+            s = t[j] + q * m[j] + carry;
+            t[j - 1] = s & STANDARD_USEBIT_MASK;
+            carry = s >> BITSPERWORD;
+        }
+        s = t[n] + carry;
+        t[n - 1] = s & STANDARD_USEBIT_MASK;
+        t[n] = t[n + 1] + (s >> BITSPERWORD);
+    }
+
+    /* u = t - m over n + 1 words, t is kept if that borrows */
+    for (j = 0; j < n; j++) u[j] = m[j];
+    u[n] = 0;
+    CtSelectWords(r, t, u, n, CtSubtractWords(u, t, u, n + 1));
+}
+
+
+LargeInt* CtModMultiply(const MontgomeryContext* ctx, const LargeInt* a, const LargeInt* b) {
+    uint32 n = ctx->words;
+    uint32* x = (uint32*)calloc(n, sizeof(uint32));
+    uint32* y = (uint32*)calloc(n, sizeof(uint32));
+    uint32* t = (uint32*)calloc(2 * (n + 2), sizeof(uint32));
+    LargeInt* ergebnis = InitLargeIntWithUint32(0, n);
+    uint32 j;
+
+    for (j = 0; j < n; j++) {
+        x[j] = CtWord(a, j);
+        y[j] = CtWord(b, j);
+    }
+    CtMontgomeryMultiplyWords(x, x, ctx->rSquared->data, ctx, t, t + n + 2);
+    CtMontgomeryMultiplyWords(ergebnis->data, x, y, ctx, t, t + n + 2);
+    CtRecomputeUsageVariables(ergebnis);
+
+    free(x);
+    free(y);
+    free(t);
+    return ergebnis;
+}
+
+
+LargeInt* CtModExp(const MontgomeryContext* ctx, const LargeInt* base, const LargeInt* exponent, uint32 exponentBits) {
+    uint32 n = ctx->words;
+    uint32* r0 = (uint32*)calloc(n, sizeof(uint32));
+    uint32* r1 = (uint32*)calloc(n, sizeof(uint32));
+    uint32* one = (uint32*)calloc(n, sizeof(uint32));
+    uint32* t = (uint32*)calloc(2 * (n + 2), sizeof(uint32));
+    uint32* u = t + n + 2;
+    LargeInt* ergebnis = InitLargeIntWithUint32(0, n);
+    sint32 i;
+    uint32 j;
+
+    one[0] = 1;
+    for (j = 0; j < n; j++) r1[j] = CtWord(base, j);
+    CtMontgomeryMultiplyWords(r0, one, ctx->rSquared->data, ctx, t, u);
+    CtMontgomeryMultiplyWords(r1, r1, ctx->rSquared->data, ctx, t, u);
+
+    /* invariant: r1 = r0 * base, both in Montgomery form */
+    for (i = (sint32)exponentBits - 1; i >= 0; i--) {
+        uint32 bit = (CtWord(exponent, i / BITSPERWORD) >> (i % BITSPERWORD)) & 1;
+        CtSwapWords(r0, r1, n, bit);
+        CtMontgomeryMultiplyWords(r1, r0, r1, ctx, t, u);
+        CtMontgomeryMultiplyWords(r0, r0, r0, ctx, t, u);
+        CtSwapWords(r0, r1, n, bit);
+    }
+
+    CtMontgomeryMultiplyWords(ergebnis->data, r0, one, ctx, t, u);
+    CtRecomputeUsageVariables(ergebnis);
+
+    free(r0);
+    free(r1);
+    free(one);
+    free(t);
+    return ergebnis;
+}
@@ -0,0 +1,59 @@
+#ifndef CONSTTIME_H
+#define CONSTTIME_H
+
+#include "largeInt.h"
+
+
+/*
+ * Constant-time counterparts of the LargeInt arithmetic. All loops run
+ * over the fixed word sizes of the arguments instead of usedWords and
+ * bitSize, and no branch or memory access depends on the values. The
+ * word sizes themselves are treated as public. Words of an argument
+ * beyond its wordSize are read as zero.
+ */
+
+
+/**
+ ** Sets r to a if condition is 1 and to b if condition is 0, for all
+ ** r->wordSize words.
+ **/
+extern void CtSelect(LargeInt* r, const LargeInt* a, const LargeInt* b, uint32 condition);
+/**
+ ** Swaps the contents of a and b if condition is 1. Both need the same
+ ** word size.
+ **/
+extern void CtSwap(LargeInt* a, LargeInt* b, uint32 condition);
+/**
+ ** Sets r to a + b modulo WORD_RADIX^r->wordSize and returns the carry.
+ **/
+extern uint32 CtAdd(LargeInt* r, const LargeInt* a, const LargeInt* b);
+/**
+ ** Sets r to a - b modulo WORD_RADIX^r->wordSize and returns the borrow.
+ **/
+extern uint32 CtSubtract(LargeInt* r, const LargeInt* a, const LargeInt* b);
+/**
+ ** Sets r to a * b. r->wordSize has to be at least
+ ** a->wordSize + b->wordSize.
+ **/
+extern void CtMultiply(LargeInt* r, const LargeInt* a, const LargeInt* b);
+/**
+ ** Computes b->usedWords and b->bitSize by looking at all words.
+ **/
+extern void CtRecomputeUsageVariables(LargeInt* b);
+/**
+ ** Returns a mod m with m->wordSize words. The running time only
+ ** depends on a->wordSize and m->wordSize.
+ **/
+extern LargeInt* CtMod(const LargeInt* a, const LargeInt* m);
+/**
+ ** Returns a * b mod m for a, b < m.
+ **/
+extern LargeInt* CtModMultiply(const MontgomeryContext* ctx, const LargeInt* a, const LargeInt* b);
+/**
+ ** Returns base^exponent mod m for base < m, computed with a
+ ** Montgomery ladder over exponentBits bits. exponentBits has to be
+ ** a public bound on the bit size of the exponent.
+ **/
+extern LargeInt* CtModExp(const MontgomeryContext* ctx, const LargeInt* base, const LargeInt* exponent, uint32 exponentBits);
+
+#endif /* #ifndef CONSTTIME_H */
@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "largeInt.h"
+#include "prime.h"
+#include "rsa.h"
+#include "constTime.h"
+
+// Measures the overhead of the constant-time operations. Build with
+//   gcc -O2 -DLARGEINT_NO_MAIN -DRSA_NO_MAIN largeInt.c prime.c constTime.c rsa.c ctBench.c
+
+
+#define ROUNDS 5
+
+
+/**
+ ** Returns a random odd number with exactly the given number of bits.
+ **/
+static LargeInt* randomOdd(uint32 bits) {
+    LargeInt* x = RandomLargeInt(bits);
+    x->data[0] |= 1;
+    x->data[(bits - 1) / BITSPERWORD] |= 1U << ((bits - 1) % BITSPERWORD);
+    RecomputeUsageVariables(x);
+    return x;
+}
+
+static double seconds(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/**
+ ** Times both exponentiations modulo a random odd modulus, once with a
+ ** random full-size exponent and once with the exponent 1. The second
+ ** pair shows whether the running time depends on the exponent.
+ **/
+static void benchModExp(uint32 bits) {
+    LargeInt* m = randomOdd(bits);
+    LargeInt* base = RandomLargeInt(bits - 1);
+    LargeInt* exponent = RandomLargeInt(bits);
+    LargeInt* small = InitLargeIntWithUint32(1, 1);
+    MontgomeryContext* ctx = InitMontgomeryContext(m);
+    double fast = 0, fastSmall = 0, ct = 0, ctSmall = 0;
+    clock_t start;
+    uint32 i;
+
+    for (i = 0; i < ROUNDS; i++) {
+        LargeInt* r1;
+        LargeInt* r2;
+        start = clock();
+        r1 = MontgomeryModExp(ctx, base, exponent);
+        fast += seconds(start);
+        start = clock();
+        r2 = CtModExp(ctx, base, exponent, bits);
+        ct += seconds(start);
+        if (Compare(r1, r2) != 0) printf("results differ!\n");
+        freeLargeInt(r1);
+        freeLargeInt(r2);
+
+        start = clock();
+        r1 = MontgomeryModExp(ctx, base, small);
+        fastSmall += seconds(start);
+        start = clock();
+        r2 = CtModExp(ctx, base, small, bits);
+        ctSmall += seconds(start);
+        freeLargeInt(r1);
+        freeLargeInt(r2);
+    }
+
+    printf("%4d bit modexp:   window %.4f s (e = 1: %.4f s)   ladder %.4f s (e = 1: %.4f s)   overhead %.2fx\n",
+           bits, fast / ROUNDS, fastSmall / ROUNDS, ct / ROUNDS, ctSmall / ROUNDS, ct / fast);
+
+    freeMontgomeryContext(ctx);
+    freeLargeInt(small);
+    freeLargeInt(exponent);
+    freeLargeInt(base);
+    freeLargeInt(m);
+}
+
+static void benchRsa(uint32 bits) {
+    RsaPrivateKey* key = GenerateRsaKey(bits);
+    double fast = 0, ct = 0;
+    clock_t start;
+    uint32 i;
+
+    for (i = 0; i < ROUNDS; i++) {
+        LargeInt* message = RandomLargeInt(bits - 1);
+        LargeInt* cipher = RsaEncrypt(&key->publicKey, message);
+        LargeInt* r1;
+        LargeInt* r2;
+        start = clock();
+        r1 = RsaDecrypt(key, cipher);
+        fast += seconds(start);
+        start = clock();
+        r2 = RsaDecryptConstantTime(key, cipher);
+        ct += seconds(start);
+        if (Compare(r1, message) != 0 || Compare(r2, message) != 0) printf("decryption failed!\n");
+        freeLargeInt(r1);
+        freeLargeInt(r2);
+        freeLargeInt(cipher);
+        freeLargeInt(message);
+    }
+
+    printf("%4d bit RSA-CRT:  variable time %.4f s   constant time %.4f s   overhead %.2fx\n",
+           bits, fast / ROUNDS, ct / ROUNDS, ct / fast);
+    freeRsaPrivateKey(key);
+}
+
+int main() {
+    benchModExp(512);
+    benchModExp(1024);
+    benchModExp(2048);
+    benchRsa(1024);
+    return 0;
+}
@@ -1,6 +1,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include "largeInt.h"
 
 
@@ -74,17 +75,10 @@ boolean IsOdd(const LargeInt* b) {
 }
 
 /**
- ** Initializes a new LargeInt with the given integer value.
- **
- ** \param[in] value The value that is to be passed to the new LargeInt.
- ** \param[wordSize] The number of 32-Bit-words that shall used in the new LargeInt.
- ** \return A LargeInt that has been initialized with the given value.
+ ** Stores the given value in x, whose data array has to be zeroed
+ ** and large enough to hold the value.
  **/
-LargeInt* InitLargeIntWithUint32(uint32 value, uint8 wordSize) {
-    LargeInt* x = (LargeInt*)calloc(1, sizeof(LargeInt));
-    x->data = (uint32*)calloc(wordSize, sizeof(uint32));
-    x->wordSize = wordSize;
-    
+static void SetUint32(LargeInt* x, uint32 value) {
     if (value == 0) {
         x->usedWords = 0;
         x->bitSize = 0;
@@ -97,15 +91,86 @@ LargeInt* InitLargeIntWithUint32(uint32 value, uint8 wordSize) {
             value = value >> BITSPERWORD;
         } 
     }
+}
+
+/**
+ ** Initializes a new LargeInt with the given integer value.
+ **
+ ** Only the fields before inlineData and the wordSize words of the
+ ** data array are allocated, in one block with the data at its end.
+ **
+ ** \param[in] value The value that is to be passed to the new LargeInt.
+ ** \param[wordSize] The number of 32-Bit-words that shall used in the new LargeInt.
+ ** \return A LargeInt that has been initialized with the given value.
+ **/
+LargeInt* InitLargeIntWithUint32(uint32 value, uint32 wordSize) {
+    LargeInt* x = (LargeInt*)malloc(offsetof(LargeInt, inlineData) + wordSize * sizeof(uint32));
+    uint32 i;
+    x->data = (uint32*)((char*)x + offsetof(LargeInt, inlineData));
+    for (i = 0; i < wordSize; i++) x->data[i] = 0;
+    x->wordSize = wordSize;
+    SetUint32(x, value);
     return x;
 }
 
 
+/**
+ ** Initializes a LargeInt that lives in memory of the caller, e.g. on
+ ** the stack. No memory is allocated unless wordSize exceeds
+ ** LARGEINT_INLINE_WORDS. Has to be released with ReleaseLocalLargeInt
+ ** instead of freeLargeInt.
+ **
+ ** \param[out] x The LargeInt to initialize.
+ ** \param[in] value The value that is to be passed to x.
+ ** \param[wordSize] The number of 32-Bit-words that shall used in x.
+ **/
+void InitLocalLargeInt(LargeInt* x, uint32 value, uint32 wordSize) {
+    uint32 i;
+    if (wordSize <= LARGEINT_INLINE_WORDS) {
+        for (i = 0; i < wordSize; i++) x->inlineData[i] = 0;
+        x->data = x->inlineData;
+    } else {
+        x->data = (uint32*)calloc(wordSize, sizeof(uint32));
+    }
+    x->wordSize = wordSize;
+    SetUint32(x, value);
+}
+
+
+/**
+ ** Releases the memory of a LargeInt that has been initialized with
+ ** InitLocalLargeInt.
+ **/
+void ReleaseLocalLargeInt(LargeInt* x) {
+    if (x->data != x->inlineData) free(x->data);
+    x->data = NULL;
+}
+
+
+/**
+ ** Returns a copy of the given LargeInt that uses wordSize words.
+ **
+ ** \param[in] x The LargeInt to copy.
+ ** \param[in] wordSize The word size of the copy. Has to be at least
+ **            x->usedWords and at least 1.
+ ** \return A freshly allocated copy of x.
+ **/
+LargeInt* CopyLargeInt(const LargeInt* x, uint32 wordSize) {
+    LargeInt* c = InitLargeIntWithUint32(0, wordSize);
+    uint32 i;
+    for (i = 0; i < x->usedWords; i++) {
+        c->data[i] = x->data[i];
+    }
+    c->usedWords = x->usedWords;
+    c->bitSize = x->bitSize;
+    return c;
+}
+
+
 /**
  * Frees the memory of the given LargeInt.
  */
 void freeLargeInt(LargeInt* x) {
-    free(x->data);
     free(x);
 }
 
@@ -144,8 +209,8 @@ LargeInt* Add(LargeInt* s1, LargeInt* s2) {
     while (i<=maxusedwords || uebertrag != 0)
     {
         ergebnis->data[i] += uebertrag;
-        ergebnis->data[i] += s1->data[i];
-        ergebnis->data[i] += s2->data[i];
+        if (i < s1->usedWords) ergebnis->data[i] += s1->data[i];
+        if (i < s2->usedWords) ergebnis->data[i] += s2->data[i];
         uebertrag = STANDARD_CALCBIT_MASK & ergebnis->data[i];
         ergebnis->data[i] = STANDARD_USEBIT_MASK & ergebnis->data[i];
         if(uebertrag>0) uebertrag = 1;
@@ -155,6 +220,104 @@ LargeInt* Add(LargeInt* s1, LargeInt* s2) {
     return ergebnis;
 }
 
+/**
+ ** Returns the bit with the given index, where index 0 denotes the
+ ** least significant bit.
+ **/
+boolean GetBit(const LargeInt* x, uint32 index) {
+    if (index >= x->bitSize) return FALSE;
+    return (x->data[index / BITSPERWORD] >> (index % BITSPERWORD)) & 1;
+}
+
+
+/**
+ ** Compares the first n words of a and b.
+ **
+ ** \return -1, 0 or 1 if a is less than, equal to or greater than b.
+ **/
+static sint32 CompareWords(const uint32* a, const uint32* b, uint32 n) {
+    while (n > 0) {
+        n--;
+        if (a[n] != b[n]) return (a[n] > b[n]) ? 1 : -1;
+    }
+    return 0;
+}
+
+
+/**
+ ** Subtracts b from a in place. b has bLen words and is treated as
+ ** zero above that, a has aLen >= bLen words.
+ **
+ ** \return The borrow out of the most significant word of a.
+ **/
+static uint32 SubtractWords(uint32* a, uint32 aLen, const uint32* b, uint32 bLen) {
+    uint32 i;
+    uint32 borrow = 0;
+    for (i = 0; i < aLen; i++) {
+        uint32 d = a[i] - ((i < bLen) ? b[i] : 0) - borrow;
+        borrow = (d & STANDARD_CALCBIT_MASK) ? 1 : 0;
+        a[i] = d & STANDARD_USEBIT_MASK;
+    }
+    return borrow;
+}
+
+
+/**
+ ** \brief Compares the two given LargeInts.
+ **
+ ** \return -1, 0 or 1 if a is less than, equal to or greater than b.
+ **/
+sint32 Compare(const LargeInt* a, const LargeInt* b) {
+    if (a->usedWords != b->usedWords) {
+        return (a->usedWords > b->usedWords) ? 1 : -1;
+    }
+    return CompareWords(a->data, b->data, a->usedWords);
+}
+
+
+/**
+ ** \brief Adds a small value to the given LargeInt.
+ **
+ ** \param[in] a The summand.
+ ** \param[in] value The value to add.
+ ** \result The sum of a and value in a LargeInt that is large
+ **         enough to hold the sum.
+ **/
+LargeInt* AddUint32(const LargeInt* a, uint32 value) {
+    LargeInt* ergebnis = CopyLargeInt(a, a->usedWords + (32 / BITSPERWORD) + 2);
+    uint32 i = 0;
+    uint32 uebertrag = value;
+
+    while (uebertrag != 0) {
+        uint32 sum = ergebnis->data[i] + (uebertrag & STANDARD_USEBIT_MASK);
+        uebertrag = (uebertrag >> BITSPERWORD) + (sum >> BITSPERWORD);
+        ergebnis->data[i] = sum & STANDARD_USEBIT_MASK;
+        i++;
+    }
+    RecomputeUsageVariables(ergebnis);
+    return ergebnis;
+}
+
+
+/**
+ ** \brief Subtracts b from a and returns the result.
+ **
+ ** Like Add, this ignores the sign of the integers, so a has to be
+ ** greater than or equal to b.
+ **
+ ** \param[in] a The minuend.
+ ** \param[in] b The subtrahend.
+ ** \result The difference a - b.
+ **/
+LargeInt* Subtract(const LargeInt* a, const LargeInt* b) {
+    LargeInt* ergebnis = CopyLargeInt(a, a->usedWords + 1);
+    SubtractWords(ergebnis->data, ergebnis->wordSize, b->data, b->usedWords);
+    RecomputeUsageVariables(ergebnis);
+    return ergebnis;
+}
+
+
+
 LargeInt* Multiply(LargeInt* m1, LargeInt* m2) {
     uint32 maxwords, maxusedwords, minreqwords, words;
     if(m1->wordSize > m2->wordSize) {
@@ -226,6 +389,311 @@ LargeInt* Multiply(LargeInt* m1, LargeInt* m2) {
 }
 
 
+/**
+ ** \brief Computes a mod m by binary long division.
+ **
+ ** \param[in] a The dividend.
+ ** \param[in] m The modulus, which must not be zero.
+ ** \result The remainder of a divided by m.
+ **/
+LargeInt* Mod(const LargeInt* a, const LargeInt* m) {
+    uint32 n = m->usedWords;
+    LargeInt* rest = InitLargeIntWithUint32(0, n + 1);
+    sint32 i;
+    uint32 j;
+
+    for (i = (sint32)a->bitSize - 1; i >= 0; i--) {
+        uint32 bit = GetBit(a, i);
+        for (j = 0; j <= n; j++) {
+            uint32 shifted = (rest->data[j] << 1) | bit;
+            bit = shifted >> BITSPERWORD;
+            rest->data[j] = shifted & STANDARD_USEBIT_MASK;
+        }
+        if (rest->data[n] != 0 || CompareWords(rest->data, m->data, n) >= 0) {
+            SubtractWords(rest->data, n + 1, m->data, n);
+        }
+    }
+    RecomputeUsageVariables(rest);
+    return rest;
+}
+
+
+/**
+ ** \brief Computes a mod m for a word-sized modulus.
+ **
+ ** Several small divisors can be handled with a single call by passing
+ ** their product and reducing the result further.
+ **
+ ** \param[in] a The dividend.
+ ** \param[in] m The modulus, 0 < m <= MAX_UINT32_MODULUS.
+ ** \result The remainder of a divided by m.
+ **/
+uint32 ModUint32(const LargeInt* a, uint32 m) {
+    uint32 rest = 0;
+    uint32 i = a->usedWords;
+    while (i > 0) {
+        i--;
+        rest = ((rest << BITSPERWORD) | a->data[i]) % m;
+    }
+    return rest;
+}
+
+
+/**
+ ** \brief Prepares Montgomery multiplication modulo m.
+ **
+ ** \param[in] m The modulus, which has to be odd.
+ ** \result A freshly allocated context that has to be freed with
+ **         freeMontgomeryContext.
+ **/
+MontgomeryContext* InitMontgomeryContext(const LargeInt* m) {
+    MontgomeryContext* ctx = (MontgomeryContext*)calloc(1, sizeof(MontgomeryContext));
+    uint32 inverse = m->data[0];
+    uint32 i;
+    LargeInt* r;
+
+    ctx->words = m->usedWords;
+    ctx->modulus = CopyLargeInt(m, ctx->words);
+
+    /* Newton iteration, every step doubles the number of correct bits */
+    for (i = 0; i < 5; i++) {
+        inverse *= 2 - m->data[0] * inverse;
+    }
+    ctx->inverse = (0 - inverse) & STANDARD_USEBIT_MASK;
+
+    r = InitLargeIntWithUint32(0, 2 * ctx->words + 1);
+    r->data[2 * ctx->words] = 1;
+    RecomputeUsageVariables(r);
+    ctx->rSquared = Mod(r, m);
+    freeLargeInt(r);
+    return ctx;
+}
+
+
+/**
+ ** Frees the memory of the given MontgomeryContext.
+ **/
+void freeMontgomeryContext(MontgomeryContext* ctx) {
+    freeLargeInt(ctx->modulus);
+    freeLargeInt(ctx->rSquared);
+    free(ctx);
+}
+
+
+/**
+ ** \brief Computes r = a * b * R^(-1) mod m.
+ **
+ ** a, b and r hold ctx->words words each and may overlap. t is
+ ** scratch space of ctx->words + 2 words.
+ **/
+static void MontgomeryMultiplyWords(uint32* r, const uint32* a, const uint32* b,
+                                    const MontgomeryContext* ctx, uint32* t) {
+    uint32 n = ctx->words;
+    const uint32* m = ctx->modulus->data;
+    uint32 i, j, s, u, carry;
+
+    for (j = 0; j < n + 2; j++) t[j] = 0;
+
+    for (i = 0; i < n; i++) {
+        carry = 0;
+        for (j = 0; j < n; j++) {
+            s = t[j] + a[i] * b[j] + carry;
+            t[j] = s & STANDARD_USEBIT_MASK;
+            carry = s >> BITSPERWORD;
+        }
+        s = t[n] + carry;
+        t[n] = s & STANDARD_USEBIT_MASK;
+        t[n + 1] = s >> BITSPERWORD;
+
+        u = (t[0] * ctx->inverse) & STANDARD_USEBIT_MASK;
+        carry = (t[0] + u * m[0]) >> BITSPERWORD;
+        for (j = 1; j < n; j++) {
+            s = t[j] + u * m[j] + carry;
+            t[j - 1] = s & STANDARD_USEBIT_MASK;
+            carry = s >> BITSPERWORD;
+        }
+        s = t[n] + carry;
+        t[n - 1] = s & STANDARD_USEBIT_MASK;
+        t[n] = t[n + 1] + (s >> BITSPERWORD);
+    }
+
+    if (t[n] != 0 || CompareWords(t, m, n) >= 0) {
+        SubtractWords(t, n + 1, m, n);
+    }
+    for (j = 0; j < n; j++) r[j] = t[j];
+}
+
+
+/**
+ ** \brief Computes a * b mod m using a prepared context.
+ **
+ ** \param[in] ctx The Montgomery context of the modulus.
+ ** \param[in] a The first factor, which has to be less than m.
+ ** \param[in] b The second factor, which has to be less than m.
+ ** \result a * b mod m.
+ **/
+LargeInt* MontgomeryModMultiply(const MontgomeryContext* ctx, const LargeInt* a, const LargeInt* b) {
+    uint32 n = ctx->words;
+    uint32* x = (uint32*)calloc(n, sizeof(uint32));
+    uint32* y = (uint32*)calloc(n, sizeof(uint32));
+    uint32* t = (uint32*)calloc(n + 2, sizeof(uint32));
+    LargeInt* ergebnis = InitLargeIntWithUint32(0, n);
+    uint32 j;
+
+    for (j = 0; j < a->usedWords; j++) x[j] = a->data[j];
+    for (j = 0; j < b->usedWords; j++) y[j] = b->data[j];
+    /* (a * R^2 * R^(-1)) * b * R^(-1) = a * b */
+    MontgomeryMultiplyWords(x, x, ctx->rSquared->data, ctx, t);
+    MontgomeryMultiplyWords(ergebnis->data, x, y, ctx, t);
+    RecomputeUsageVariables(ergebnis);
+
+    free(x);
+    free(y);
+    free(t);
+    return ergebnis;
+}
+
+
+#define MODEXP_WINDOW_BITS 4
+
+/**
+ ** \brief Computes base^exponent mod m using a prepared context.
+ **
+ ** The exponent is processed in fixed windows of MODEXP_WINDOW_BITS
+ ** bits, so only one multiplication per window is needed.
+ **
+ ** \param[in] ctx The Montgomery context of the modulus.
+ ** \param[in] base The base. It is reduced mod m if necessary.
+ ** \param[in] exponent The exponent.
+ ** \result base^exponent mod m.
+ **/
+LargeInt* MontgomeryModExp(const MontgomeryContext* ctx, const LargeInt* base, const LargeInt* exponent) {
+    uint32 n = ctx->words;
+    uint32* table = (uint32*)calloc((1 << MODEXP_WINDOW_BITS) * n, sizeof(uint32));
+    uint32* acc = (uint32*)calloc(n, sizeof(uint32));
+    uint32* t = (uint32*)calloc(n + 2, sizeof(uint32));
+    LargeInt* reduced = NULL;
+    LargeInt* ergebnis;
+    uint32 i, j, window, bits;
+
+    if (Compare(base, ctx->modulus) >= 0) {
+        reduced = Mod(base, ctx->modulus);
+        base = reduced;
+    }
+
+    /* table[w] = base^w in Montgomery form, table[0] = R mod m */
+    acc[0] = 1;
+    MontgomeryMultiplyWords(table, acc, ctx->rSquared->data, ctx, t);
+    for (j = 0; j < n; j++) acc[j] = (j < base->usedWords) ? base->data[j] : 0;
+    MontgomeryMultiplyWords(&table[n], acc, ctx->rSquared->data, ctx, t);
+    for (i = 2; i < (1U << MODEXP_WINDOW_BITS); i++) {
+        MontgomeryMultiplyWords(&table[i * n], &table[(i - 1) * n], &table[n], ctx, t);
+    }
+
+    for (j = 0; j < n; j++) acc[j] = table[j];
+    i = exponent->bitSize;
+    while (i > 0) {
+        bits = i % MODEXP_WINDOW_BITS;
+        if (bits == 0) bits = MODEXP_WINDOW_BITS;
+        window = 0;
+        for (j = 0; j < bits; j++) {
+            i--;
+            window = (window << 1) | GetBit(exponent, i);
+            MontgomeryMultiplyWords(acc, acc, acc, ctx, t);
+        }
+        if (window != 0) {
+            MontgomeryMultiplyWords(acc, acc, &table[window * n], ctx, t);
+        }
+    }
+
+    /* leave Montgomery form by multiplying with 1 */
+    for (j = 0; j < n; j++) table[j] = 0;
+    table[0] = 1;
+    ergebnis = InitLargeIntWithUint32(0, n);
+    MontgomeryMultiplyWords(ergebnis->data, acc, table, ctx, t);
+    RecomputeUsageVariables(ergebnis);
+
+    if (reduced != NULL) freeLargeInt(reduced);
+    free(table);
+    free(acc);
+    free(t);
+    return ergebnis;
+}
+
+
+/**
+ ** \brief Computes base^exponent mod m for a word-sized exponent.
+ **
+ ** Unlike MontgomeryModExp, no window table is built, which makes
+ ** this the faster choice for short exponents such as 65537, which
+ ** takes 16 squarings and one multiplication.
+ **
+ ** \param[in] ctx The Montgomery context of the modulus.
+ ** \param[in] base The base. It is reduced mod m if necessary.
+ ** \param[in] exponent The exponent.
+ ** \result base^exponent mod m.
+ **/
+LargeInt* MontgomeryModExpUint32(const MontgomeryContext* ctx, const LargeInt* base, uint32 exponent) {
+    uint32 n = ctx->words;
+    uint32* x = (uint32*)calloc(n, sizeof(uint32));
+    uint32* acc = (uint32*)calloc(n, sizeof(uint32));
+    uint32* t = (uint32*)calloc(n + 2, sizeof(uint32));
+    LargeInt* reduced = NULL;
+    LargeInt* ergebnis = InitLargeIntWithUint32(0, n);
+    sint32 i;
+    uint32 j;
+
+    if (Compare(base, ctx->modulus) >= 0) {
+        reduced = Mod(base, ctx->modulus);
+        base = reduced;
+    }
+
+    for (j = 0; j < base->usedWords; j++) x[j] = base->data[j];
+    MontgomeryMultiplyWords(x, x, ctx->rSquared->data, ctx, t);
+
+    /* the top bit of the exponent only copies x */
+    if (exponent == 0) {
+        acc[0] = 1;
+        MontgomeryMultiplyWords(acc, acc, ctx->rSquared->data, ctx, t);
+    } else {
+        for (j = 0; j < n; j++) acc[j] = x[j];
+    }
+    for (i = 30 - (sint32)GetNumberOfLeadingZeroes(exponent); i >= 0; i--) {
+        MontgomeryMultiplyWords(acc, acc, acc, ctx, t);
+        if ((exponent >> i) & 1) {
+            MontgomeryMultiplyWords(acc, acc, x, ctx, t);
+        }
+    }
+
+    for (j = 0; j < n; j++) x[j] = 0;
+    x[0] = 1;
+    MontgomeryMultiplyWords(ergebnis->data, acc, x, ctx, t);
+    RecomputeUsageVariables(ergebnis);
+
+    if (reduced != NULL) freeLargeInt(reduced);
+    free(x);
+    free(acc);
+    free(t);
+    return ergebnis;
+}
+
+
+/**
+ ** \brief Computes base^exponent mod m.
+ **
+ ** \param[in] base The base.
+ ** \param[in] exponent The exponent.
+ ** \param[in] m The modulus, which has to be odd.
+ ** \result base^exponent mod m.
+ **/
+LargeInt* ModExp(const LargeInt* base, const LargeInt* exponent, const LargeInt* m) {
+    MontgomeryContext* ctx = InitMontgomeryContext(m);
+    LargeInt* ergebnis = MontgomeryModExp(ctx, base, exponent);
+    freeMontgomeryContext(ctx);
+    return ergebnis;
+}
+
+
 void printLargeInt(LargeInt *x) {
     int i = x->bitSize - 1;
     while (i >= 0) {
@@ -246,6 +714,8 @@ void printLargeInt(LargeInt *x) {
 
 // Verstehen Sie die untige main-Funktion bitte als Anstoß zum 
 // Testen Ihres Codes. Fügen Sie weitere, sinnvolle Tests hinzu!
+// Define LARGEINT_NO_MAIN to link this file into other programs.
+#ifndef LARGEINT_NO_MAIN
 int main() {
     LargeInt* x = InitLargeIntWithUint32(70000, 5);
     LargeInt* y = InitLargeIntWithUint32(80000, 5);
@@ -264,6 +734,4 @@ int main() {
     printLargeInt(test);
     return 0;
 }
-
-
-
+#endif /* #ifndef LARGEINT_NO_MAIN */
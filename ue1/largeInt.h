@@ -20,6 +20,13 @@ typedef uint8 boolean;
 #define STANDARD_USEBIT_MASK  (uint32)(WORD_RADIX - 1)
 #define STANDARD_CALCBIT_MASK (uint32)(0xFFFFFFFFU ^ STANDARD_USEBIT_MASK)
 
+/* Largest modulus for which ModUint32 can not overflow. */
+#define MAX_UINT32_MODULUS (uint32)(1U << (32 - BITSPERWORD))
+
+/* Local LargeInts of up to this many bits keep their data inline. */
+#define LARGEINT_INLINE_BITS 320U
+#define LARGEINT_INLINE_WORDS ((LARGEINT_INLINE_BITS + BITSPERWORD - 1) / BITSPERWORD)
+
 
 
 /**
@@ -57,16 +64,75 @@ typedef uint8 boolean;
  **        If all words in the data array are set to 0, the
  **        value of this variable is 0.
  **/
+/**
+ ** inlineData
+ **        Storage for the data array. A LargeInt from
+ **        InitLargeIntWithUint32 is allocated as the fields before
+ **        inlineData plus exactly wordSize words, so its data is the
+ **        tail of the allocation and nothing is wasted. A local
+ **        LargeInt on the stack has the full LARGEINT_INLINE_WORDS
+ **        and only allocates if wordSize exceeds that. Either way,
+ **        data points into memory owned by the LargeInt, so a
+ **        LargeInt must not be copied by value.
+ **/
 typedef struct {
     uint32* data;
     uint32 bitSize;
     uint32 wordSize;
     uint32 usedWords;
+    uint32 inlineData[LARGEINT_INLINE_WORDS];
 } LargeInt;
 
+/**
+ ** MontgomeryContext
+ ** Precomputed values for Montgomery multiplication modulo an odd
+ ** modulus m with R = WORD_RADIX^words.
+ **/
+/**
+ ** modulus
+ **        A copy of m with exactly words data words.
+ **/
+/**
+ ** words
+ **        The number of used words of m.
+ **/
+/**
+ ** inverse
+ **        -m^(-1) mod WORD_RADIX.
+ **/
+/**
+ ** rSquared
+ **        R^2 mod m, used to convert values into Montgomery form.
+ **/
+typedef struct {
+    LargeInt* modulus;
+    uint32 words;
+    uint32 inverse;
+    LargeInt* rSquared;
+} MontgomeryContext;
+
 extern boolean IsEven(const LargeInt* b);
 extern boolean IsOdd(const LargeInt* b);
-extern LargeInt* InitLargeIntWithUint32(uint32 value, uint8 wordSize);
+extern LargeInt* InitLargeIntWithUint32(uint32 value, uint32 wordSize);
+extern void InitLocalLargeInt(LargeInt* x, uint32 value, uint32 wordSize);
+extern void ReleaseLocalLargeInt(LargeInt* x);
+extern LargeInt* CopyLargeInt(const LargeInt* x, uint32 wordSize);
+extern void freeLargeInt(LargeInt* x);
+extern void RecomputeUsageVariables(LargeInt* b);
+extern boolean GetBit(const LargeInt* x, uint32 index);
+extern sint32 Compare(const LargeInt* a, const LargeInt* b);
 extern LargeInt* Add(LargeInt* s1, LargeInt* s2);
+extern LargeInt* AddUint32(const LargeInt* a, uint32 value);
+extern LargeInt* Subtract(const LargeInt* a, const LargeInt* b);
+extern LargeInt* Multiply(LargeInt* m1, LargeInt* m2);
+extern LargeInt* Mod(const LargeInt* a, const LargeInt* m);
+extern uint32 ModUint32(const LargeInt* a, uint32 m);
+extern MontgomeryContext* InitMontgomeryContext(const LargeInt* m);
+extern void freeMontgomeryContext(MontgomeryContext* ctx);
+extern LargeInt* MontgomeryModMultiply(const MontgomeryContext* ctx, const LargeInt* a, const LargeInt* b);
+extern LargeInt* MontgomeryModExp(const MontgomeryContext* ctx, const LargeInt* base, const LargeInt* exponent);
+extern LargeInt* MontgomeryModExpUint32(const MontgomeryContext* ctx, const LargeInt* base, uint32 exponent);
+extern LargeInt* ModExp(const LargeInt* base, const LargeInt* exponent, const LargeInt* m);
+extern void printLargeInt(LargeInt *x);
 
-#endif /* #ifndef ARITH_BIGINT_H */
\ No newline at end of file
+#endif /* #ifndef ARITH_BIGINT_H */
@@ -0,0 +1,345 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "prime.h"
+
+
+/* The first primes, used as deterministic Miller-Rabin bases. */
+#define DETERMINISTIC_BASE_COUNT 13
+/* Below 2^81, the first 13 prime bases give an exact answer. */
+#define DETERMINISTIC_BIT_LIMIT 81
+/* Largest distance the sieve in NextPrime covers before rebasing. */
+#define SIEVE_MAX_DELTA (uint32)(1U << 20)
+
+
+/**
+ ** primeGroup
+ ** A run of consecutive small primes whose product is small enough
+ ** for ModUint32. One long remainder per group is enough, the
+ ** remainders modulo the single primes are then computed in uint32.
+ **/
+typedef struct {
+    uint32 product;
+    uint32 first;
+    uint32 count;
+} primeGroup;
+
+
+static uint32 smallPrimes[SMALL_PRIME_LIMIT];
+static uint32 smallPrimeCount = 0;
+static primeGroup primeGroups[SMALL_PRIME_LIMIT];
+static uint32 primeGroupCount = 0;
+
+
+/**
+ ** Fills the table of small primes with the sieve of Eratosthenes and
+ ** splits it into groups. Does nothing if this has already been done.
+ **/
+static void InitSmallPrimes(void) {
+    static boolean composite[SMALL_PRIME_LIMIT];
+    uint32 i, j;
+
+    if (smallPrimeCount > 0) return;
+
+    for (i = 2; i < SMALL_PRIME_LIMIT; i++) {
+        if (composite[i]) continue;
+        smallPrimes[smallPrimeCount] = i;
+        smallPrimeCount++;
+        for (j = i * i; j < SMALL_PRIME_LIMIT; j += i) {
+            composite[j] = TRUE;
+        }
+    }
+
+    /* 2 is never used for trial division of odd candidates */
+    i = 1;
+    while (i < smallPrimeCount) {
+        primeGroup *g = &primeGroups[primeGroupCount];
+        g->product = 1;
+        g->first = i;
+        g->count = 0;
+        while (i < smallPrimeCount && g->product <= MAX_UINT32_MODULUS / smallPrimes[i]) {
+            g->product *= smallPrimes[i];
+            g->count++;
+            i++;
+        }
+        primeGroupCount++;
+    }
+}
+
+
+/**
+ ** Computes n mod p for all odd small primes p and stores the results
+ ** in residues, which has to hold smallPrimeCount values.
+ **/
+static void ComputeResidues(const LargeInt* n, uint32* residues) {
+    uint32 g, i;
+    for (g = 0; g < primeGroupCount; g++) {
+        uint32 r = ModUint32(n, primeGroups[g].product);
+        for (i = primeGroups[g].first; i < primeGroups[g].first + primeGroups[g].count; i++) {
+            residues[i] = r % smallPrimes[i];
+        }
+    }
+}
+
+
+/**
+ ** Returns the value of x, which has to fit into 32 bits.
+ **/
+static uint32 ToUint32(const LargeInt* x) {
+    uint32 value = 0;
+    uint32 i = x->usedWords;
+    while (i > 0) {
+        i--;
+        value = (value << BITSPERWORD) | x->data[i];
+    }
+    return value;
+}
+
+
+/**
+ ** Returns x shifted to the right by the given number of bits.
+ **/
+static LargeInt* ShiftRight(const LargeInt* x, uint32 bits) {
+    LargeInt* ergebnis = InitLargeIntWithUint32(0, x->usedWords + 1);
+    uint32 i;
+    for (i = bits; i < x->bitSize; i++) {
+        if (GetBit(x, i)) {
+            ergebnis->data[(i - bits) / BITSPERWORD] |= 1U << ((i - bits) % BITSPERWORD);
+        }
+    }
+    RecomputeUsageVariables(ergebnis);
+    return ergebnis;
+}
+
+
+/**
+ ** Fills the given array with random bytes, preferably from the
+ ** random device of the operating system.
+ **/
+static void RandomBytes(unsigned char* buffer, uint32 count) {
+    FILE* f = fopen("/dev/urandom", "rb");
+    uint32 done = 0;
+    if (f != NULL) {
+        done = fread(buffer, 1, count, f);
+        fclose(f);
+    }
+    while (done < count) {
+        buffer[done] = (unsigned char)rand();
+        done++;
+    }
+}
+
+
+LargeInt* RandomLargeInt(uint32 bits) {
+    uint32 words = bits / BITSPERWORD + 1;
+    unsigned char* bytes = (unsigned char*)calloc(words, 1);
+    LargeInt* x = InitLargeIntWithUint32(0, words);
+    uint32 i;
+
+    RandomBytes(bytes, words);
+    for (i = 0; i < words; i++) {
+        x->data[i] = bytes[i] & STANDARD_USEBIT_MASK;
+    }
+    /* clear everything above the requested number of bits */
+    x->data[words - 1] &= (1U << (bits % BITSPERWORD)) - 1;
+    free(bytes);
+    RecomputeUsageVariables(x);
+    return x;
+}
+
+
+boolean HasSmallFactor(const LargeInt* n) {
+    uint32 g, i;
+    InitSmallPrimes();
+
+    if (IsEven(n)) return n->bitSize != 2;
+    for (g = 0; g < primeGroupCount; g++) {
+        uint32 r = ModUint32(n, primeGroups[g].product);
+        for (i = primeGroups[g].first; i < primeGroups[g].first + primeGroups[g].count; i++) {
+            if (r % smallPrimes[i] == 0) {
+                return n->bitSize > 32 || ToUint32(n) != smallPrimes[i];
+            }
+        }
+    }
+    return FALSE;
+}
+
+
+/**
+ ** Returns FALSE if the base a proves n to be composite. d and s
+ ** describe n - 1 = d * 2^s with odd d.
+ **/
+static boolean MillerRabinRound(MontgomeryContext* ctx, const LargeInt* a, const LargeInt* d, uint32 s,
+                                const LargeInt* one, const LargeInt* nMinusOne) {
+    LargeInt* x = MontgomeryModExp(ctx, a, d);
+    boolean prime = FALSE;
+    uint32 r;
+
+    /* bases that are multiples of n prove nothing */
+    if (x->bitSize == 0 || Compare(x, one) == 0 || Compare(x, nMinusOne) == 0) {
+        freeLargeInt(x);
+        return TRUE;
+    }
+    for (r = 1; r < s; r++) {
+        LargeInt* y = MontgomeryModMultiply(ctx, x, x);
+        freeLargeInt(x);
+        x = y;
+        if (Compare(x, nMinusOne) == 0) {
+            prime = TRUE;
+            break;
+        }
+    }
+    freeLargeInt(x);
+    return prime;
+}
+
+
+boolean MillerRabin(const LargeInt* n, const uint32* bases, uint32 baseCount) {
+    MontgomeryContext* ctx = InitMontgomeryContext(n);
+    LargeInt one, two;
+    LargeInt* nMinusOne;
+    LargeInt* nMinusTwo;
+    LargeInt* d;
+    boolean prime = TRUE;
+    uint32 s = 0;
+    uint32 b;
+
+    InitLocalLargeInt(&one, 1, 1);
+    InitLocalLargeInt(&two, 2, 1);
+    nMinusOne = Subtract(n, &one);
+    nMinusTwo = Subtract(n, &two);
+    while (!GetBit(nMinusOne, s)) s++;
+    d = ShiftRight(nMinusOne, s);
+
+    for (b = 0; b < baseCount && prime; b++) {
+        if (bases != NULL) {
+            LargeInt a;
+            InitLocalLargeInt(&a, bases[b], 32 / BITSPERWORD + 1);
+            prime = MillerRabinRound(ctx, &a, d, s, &one, nMinusOne);
+            ReleaseLocalLargeInt(&a);
+        } else {
+            /* rejection sampling keeps the base uniform in [2, n - 2] */
+            LargeInt* a = RandomLargeInt(n->bitSize);
+            while (Compare(a, &two) < 0 || Compare(a, nMinusTwo) > 0) {
+                freeLargeInt(a);
+                a = RandomLargeInt(n->bitSize);
+            }
+            prime = MillerRabinRound(ctx, a, d, s, &one, nMinusOne);
+            freeLargeInt(a);
+        }
+    }
+
+    freeLargeInt(d);
+    freeLargeInt(nMinusTwo);
+    freeLargeInt(nMinusOne);
+    ReleaseLocalLargeInt(&two);
+    ReleaseLocalLargeInt(&one);
+    freeMontgomeryContext(ctx);
+    return prime;
+}
+
+
+/**
+ ** Returns the number of Miller-Rabin rounds with random bases needed
+ ** for an error probability below 2^-100 for a random candidate of
+ ** the given size (FIPS 186-4, table C.2).
+ **/
+static uint32 MillerRabinRounds(uint32 bits) {
+    if (bits >= 1536) return 3;
+    if (bits >= 1024) return 4;
+    if (bits >= 512) return 7;
+    return 10;
+}
+
+
+/**
+ ** Miller-Rabin for an odd n without small factors: the first 13
+ ** primes as bases up to the deterministic bound, random bases with
+ ** the FIPS round count above it.
+ **/
+static boolean MillerRabinTest(const LargeInt* n) {
+    if (n->bitSize <= DETERMINISTIC_BIT_LIMIT) {
+        return MillerRabin(n, smallPrimes, DETERMINISTIC_BASE_COUNT);
+    }
+    return MillerRabin(n, NULL, MillerRabinRounds(n->bitSize));
+}
+
+
+boolean IsProbablePrime(const LargeInt* n) {
+    uint32 i;
+    InitSmallPrimes();
+
+    if (n->bitSize <= 11) {
+        uint32 value = ToUint32(n);
+        for (i = 0; i < smallPrimeCount; i++) {
+            if (smallPrimes[i] == value) return TRUE;
+        }
+        return FALSE;
+    }
+    if (HasSmallFactor(n)) return FALSE;
+    return MillerRabinTest(n);
+}
+
+
+LargeInt* NextPrime(const LargeInt* start) {
+    uint32* residues;
+    LargeInt* base;
+    uint32 delta = 0;
+    uint32 i;
+    InitSmallPrimes();
+
+    if (start->bitSize <= 11) {
+        uint32 value = ToUint32(start);
+        for (i = 0; i < smallPrimeCount; i++) {
+            if (smallPrimes[i] >= value) return InitLargeIntWithUint32(smallPrimes[i], 32 / BITSPERWORD + 1);
+        }
+    }
+
+    residues = (uint32*)calloc(smallPrimeCount, sizeof(uint32));
+    base = AddUint32(start, IsEven(start) ? 1 : 0);
+    ComputeResidues(base, residues);
+
+    while (1<2) {
+        /* base + delta is odd and larger than all small primes, so a
+         * vanishing residue means that it is composite */
+        for (i = 1; i < smallPrimeCount; i++) {
+            if ((residues[i] + delta) % smallPrimes[i] == 0) break;
+        }
+        if (i == smallPrimeCount) {
+            LargeInt* candidate = AddUint32(base, delta);
+            if (MillerRabinTest(candidate)) {
+                freeLargeInt(base);
+                free(residues);
+                return candidate;
+            }
+            freeLargeInt(candidate);
+        }
+
+        delta += 2;
+        if (delta >= SIEVE_MAX_DELTA) {
+            LargeInt* next = AddUint32(base, delta);
+            freeLargeInt(base);
+            base = next;
+            ComputeResidues(base, residues);
+            delta = 0;
+        }
+    }
+}
+
+
+LargeInt* GeneratePrime(uint32 bits) {
+    while (1<2) {
+        LargeInt* start = RandomLargeInt(bits);
+        LargeInt* prime;
+        uint32 top = bits - 1;
+
+        start->data[top / BITSPERWORD] |= 1U << (top % BITSPERWORD);
+        top--;
+        start->data[top / BITSPERWORD] |= 1U << (top % BITSPERWORD);
+        RecomputeUsageVariables(start);
+
+        prime = NextPrime(start);
+        freeLargeInt(start);
+        if (prime->bitSize == bits) return prime;
+        freeLargeInt(prime);
+    }
+}
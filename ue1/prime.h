@@ -0,0 +1,48 @@
+#ifndef PRIME_H
+#define PRIME_H
+
+#include "largeInt.h"
+
+
+/* All primes below this limit are used for trial division. */
+#define SMALL_PRIME_LIMIT 2048U
+
+
+/**
+ ** Returns a uniformly distributed random LargeInt with at most
+ ** the given number of bits.
+ **/
+extern LargeInt* RandomLargeInt(uint32 bits);
+/**
+ ** Returns TRUE if n is divisible by one of the small primes and is
+ ** not equal to that prime.
+ **/
+extern boolean HasSmallFactor(const LargeInt* n);
+/**
+ ** Runs the Miller-Rabin test on the odd number n > 3 for each of
+ ** the given bases, or for baseCount random bases from [2, n - 2] if
+ ** bases is NULL. Returns FALSE as soon as one base proves n to be
+ ** composite.
+ **/
+extern boolean MillerRabin(const LargeInt* n, const uint32* bases, uint32 baseCount);
+/**
+ ** Returns TRUE if n is prime with overwhelming probability. For n
+ ** below 2^81 the first 13 primes are used as bases and the answer is
+ ** exact. Above, the bases are drawn at random from [2, n - 2] with
+ ** the round counts of FIPS 186-4, so even a composite chosen to fool
+ ** fixed bases passes with probability at most 4^-rounds.
+ **/
+extern boolean IsProbablePrime(const LargeInt* n);
+/**
+ ** Returns the smallest probable prime that is greater than or equal
+ ** to start.
+ **/
+extern LargeInt* NextPrime(const LargeInt* start);
+/**
+ ** Returns a random probable prime with exactly the given number of
+ ** bits, bits >= 2. The two most significant bits are set, so the
+ ** product of two such primes has exactly 2 * bits bits.
+ **/
+extern LargeInt* GeneratePrime(uint32 bits);
+
+#endif /* #ifndef PRIME_H */
@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "rsa.h"
+#include "prime.h"
+#include "constTime.h"
+
+
+/**
+ ** Returns x * factor.
+ **/
+static LargeInt* MultiplyUint32(const LargeInt* x, uint32 factor) {
+    LargeInt f;
+    LargeInt* ergebnis;
+    InitLocalLargeInt(&f, factor, 32 / BITSPERWORD + 1);
+    ergebnis = Multiply((LargeInt*)x, &f);
+    ReleaseLocalLargeInt(&f);
+    return ergebnis;
+}
+
+
+/**
+ ** Returns x / divisor, where divisor <= MAX_UINT32_MODULUS. The
+ ** remainder is dropped.
+ **/
+static LargeInt* DivideUint32(const LargeInt* x, uint32 divisor) {
+    LargeInt* ergebnis = InitLargeIntWithUint32(0, x->usedWords + 1);
+    uint32 rest = 0;
+    uint32 i = x->usedWords;
+    while (i > 0) {
+        i--;
+        rest = (rest << BITSPERWORD) | x->data[i];
+        ergebnis->data[i] = rest / divisor;
+        rest = rest % divisor;
+    }
+    RecomputeUsageVariables(ergebnis);
+    return ergebnis;
+}
+
+
+/**
+ ** Returns a^(-1) mod m for word-sized, coprime a and m, computed with
+ ** the extended Euclidean algorithm.
+ **/
+static uint32 InverseUint32(uint32 a, uint32 m) {
+    long long r0 = m, r1 = a, t0 = 0, t1 = 1;
+    while (r1 != 0) {
+        long long q = r0 / r1;
+        long long h = r0 - q * r1;
+        r0 = r1;
+        r1 = h;
+        h = t0 - q * t1;
+        t0 = t1;
+        t1 = h;
+    }
+    if (t0 < 0) t0 += m;
+    return (uint32)t0;
+}
+
+
+/**
+ ** \brief Computes e^(-1) mod x for a small prime e that does not
+ **        divide x.
+ **
+ ** With k = -x^(-1) mod e, the number k * x + 1 is divisible by e and
+ ** (k * x + 1) / e is the inverse. This needs no long division of
+ ** LargeInts.
+ **/
+static LargeInt* InverseOfExponent(uint32 e, const LargeInt* x) {
+    uint32 k = e - InverseUint32(ModUint32(x, e), e);
+    LargeInt* kx = MultiplyUint32(x, k);
+    LargeInt* kx1 = AddUint32(kx, 1);
+    LargeInt* ergebnis = DivideUint32(kx1, e);
+    freeLargeInt(kx);
+    freeLargeInt(kx1);
+    return ergebnis;
+}
+
+
+/**
+ ** Returns a prime with the given number of bits for which p - 1 is
+ ** not divisible by e.
+ **/
+static LargeInt* GenerateRsaPrime(uint32 bits, uint32 e) {
+    while (1<2) {
+        LargeInt* p = GeneratePrime(bits);
+        if (ModUint32(p, e) != 1) return p;
+        freeLargeInt(p);
+    }
+}
+
+
+RsaPrivateKey* GenerateRsaKey(uint32 bits) {
+    RsaPrivateKey* key = (RsaPrivateKey*)calloc(1, sizeof(RsaPrivateKey));
+    uint32 e = RSA_PUBLIC_EXPONENT;
+    LargeInt one;
+    LargeInt* pMinusOne;
+    LargeInt* qMinusOne;
+    LargeInt* phi;
+    LargeInt* pMinusTwo;
+
+    InitLocalLargeInt(&one, 1, 1);
+    key->p = GenerateRsaPrime(bits - bits / 2, e);
+    do {
+        if (key->q != NULL) freeLargeInt(key->q);
+        key->q = GenerateRsaPrime(bits / 2, e);
+    } while (Compare(key->p, key->q) == 0);
+
+    key->publicKey.n = Multiply(key->p, key->q);
+    key->publicKey.e = e;
+    key->publicKey.nContext = InitMontgomeryContext(key->publicKey.n);
+
+    pMinusOne = Subtract(key->p, &one);
+    qMinusOne = Subtract(key->q, &one);
+    phi = Multiply(pMinusOne, qMinusOne);
+    key->d = InverseOfExponent(e, phi);
+    key->dP = InverseOfExponent(e, pMinusOne);
+    key->dQ = InverseOfExponent(e, qMinusOne);
+
+    /* p is prime, so q^(p-2) = q^(-1) mod p */
+    key->pContext = InitMontgomeryContext(key->p);
+    key->qContext = InitMontgomeryContext(key->q);
+    pMinusTwo = Subtract(pMinusOne, &one);
+    key->qInv = MontgomeryModExp(key->pContext, key->q, pMinusTwo);
+
+    freeLargeInt(pMinusTwo);
+    freeLargeInt(phi);
+    freeLargeInt(qMinusOne);
+    freeLargeInt(pMinusOne);
+    ReleaseLocalLargeInt(&one);
+    return key;
+}
+
+
+void freeRsaPrivateKey(RsaPrivateKey* key) {
+    freeLargeInt(key->publicKey.n);
+    freeMontgomeryContext(key->publicKey.nContext);
+    freeLargeInt(key->d);
+    freeLargeInt(key->p);
+    freeLargeInt(key->q);
+    freeLargeInt(key->dP);
+    freeLargeInt(key->dQ);
+    freeLargeInt(key->qInv);
+    freeMontgomeryContext(key->pContext);
+    freeMontgomeryContext(key->qContext);
+    free(key);
+}
+
+
+LargeInt* RsaEncrypt(const RsaPublicKey* key, const LargeInt* message) {
+    return MontgomeryModExpUint32(key->nContext, message, key->e);
+}
+
+
+LargeInt* RsaDecrypt(const RsaPrivateKey* key, const LargeInt* cipher) {
+#ifdef RSA_CONSTANT_TIME
+    return RsaDecryptConstantTime(key, cipher);
+#else
+    LargeInt* m1 = MontgomeryModExp(key->pContext, cipher, key->dP);
+    LargeInt* m2 = MontgomeryModExp(key->qContext, cipher, key->dQ);
+    LargeInt* m2ModP;
+    LargeInt* diff;
+    LargeInt* h;
+    LargeInt* hq;
+    LargeInt* ergebnis;
+
+    /* Garner: m = m2 + q * (qInv * (m1 - m2) mod p) */
+    m2ModP = (Compare(m2, key->p) >= 0) ? Mod(m2, key->p) : CopyLargeInt(m2, m2->usedWords + 1);
+    if (Compare(m1, m2ModP) >= 0) {
+        diff = Subtract(m1, m2ModP);
+    } else {
+        LargeInt* negative = Subtract(m2ModP, m1);
+        diff = Subtract(key->p, negative);
+        freeLargeInt(negative);
+    }
+    h = MontgomeryModMultiply(key->pContext, key->qInv, diff);
+    hq = Multiply(h, key->q);
+    ergebnis = Add(hq, m2);
+
+    freeLargeInt(hq);
+    freeLargeInt(h);
+    freeLargeInt(diff);
+    freeLargeInt(m2ModP);
+    freeLargeInt(m2);
+    freeLargeInt(m1);
+    return ergebnis;
+#endif
+}
+
+
+LargeInt* RsaDecryptConstantTime(const RsaPrivateKey* key, const LargeInt* cipher) {
+    const LargeInt* p = key->pContext->modulus;
+    const LargeInt* q = key->qContext->modulus;
+    LargeInt* cP = CtMod(cipher, p);
+    LargeInt* cQ = CtMod(cipher, q);
+    LargeInt* m1 = CtModExp(key->pContext, cP, key->dP, p->wordSize * BITSPERWORD);
+    LargeInt* m2 = CtModExp(key->qContext, cQ, key->dQ, q->wordSize * BITSPERWORD);
+    LargeInt* m2ModP = CtMod(m2, p);
+    LargeInt diff;
+    LargeInt diffPlusP;
+    LargeInt* h;
+    LargeInt* hq;
+    LargeInt* ergebnis;
+    uint32 borrow;
+
+    /* Garner as in RsaDecrypt, p is added back without a branch */
+    InitLocalLargeInt(&diff, 0, p->wordSize);
+    InitLocalLargeInt(&diffPlusP, 0, p->wordSize);
+    borrow = CtSubtract(&diff, m1, m2ModP);
+    CtAdd(&diffPlusP, &diff, p);
+    CtSelect(&diff, &diffPlusP, &diff, borrow);
+    h = CtModMultiply(key->pContext, key->qInv, &diff);
+    hq = InitLargeIntWithUint32(0, h->wordSize + q->wordSize);
+    CtMultiply(hq, h, q);
+    ergebnis = InitLargeIntWithUint32(0, hq->wordSize + 1);
+    CtAdd(ergebnis, hq, m2);
+
+    freeLargeInt(hq);
+    freeLargeInt(h);
+    ReleaseLocalLargeInt(&diffPlusP);
+    ReleaseLocalLargeInt(&diff);
+    freeLargeInt(m2ModP);
+    freeLargeInt(m2);
+    freeLargeInt(m1);
+    freeLargeInt(cQ);
+    freeLargeInt(cP);
+    return ergebnis;
+}
+
+
+LargeInt* RsaDecryptWithoutCrt(const RsaPrivateKey* key, const LargeInt* cipher) {
+    return MontgomeryModExp(key->publicKey.nContext, cipher, key->d);
+}
+
+
+LargeInt* RsaSign(const RsaPrivateKey* key, const LargeInt* message) {
+    return RsaDecrypt(key, message);
+}
+
+
+boolean RsaVerify(const RsaPublicKey* key, const LargeInt* message, const LargeInt* signature) {
+    LargeInt* expected = RsaEncrypt(key, signature);
+    boolean valid = (Compare(expected, message) == 0);
+    freeLargeInt(expected);
+    return valid;
+}
+
+
+
+// Build with
+//   gcc -DLARGEINT_NO_MAIN largeInt.c prime.c constTime.c rsa.c
+// Define RSA_NO_MAIN to link this file into other programs and
+// RSA_CONSTANT_TIME to use RsaDecryptConstantTime for all private-key
+// operations.
+#ifndef RSA_NO_MAIN
+int main() {
+    uint32 bits = 1024;
+    uint32 rounds = 10;
+    uint32 i;
+    clock_t start;
+    double crtTime = 0, plainTime = 0;
+
+    start = clock();
+    RsaPrivateKey* key = GenerateRsaKey(bits);
+    printf("%d-bit key generated in %.3f s\n", bits, (double)(clock() - start) / CLOCKS_PER_SEC);
+    printf("n = ");
+    printLargeInt(key->publicKey.n);
+
+    for (i = 0; i < rounds; i++) {
+        LargeInt* message = RandomLargeInt(bits - 1);
+        LargeInt* cipher = RsaEncrypt(&key->publicKey, message);
+
+        start = clock();
+        LargeInt* crt = RsaDecrypt(key, cipher);
+        crtTime += (double)(clock() - start) / CLOCKS_PER_SEC;
+        start = clock();
+        LargeInt* plain = RsaDecryptWithoutCrt(key, cipher);
+        plainTime += (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        if (Compare(crt, message) != 0 || Compare(plain, message) != 0) {
+            printf("decryption failed in round %d\n", i);
+            return 1;
+        }
+
+        LargeInt* signature = RsaSign(key, message);
+        if (!RsaVerify(&key->publicKey, message, signature)) {
+            printf("signature check failed in round %d\n", i);
+            return 1;
+        }
+
+        freeLargeInt(signature);
+        freeLargeInt(plain);
+        freeLargeInt(crt);
+        freeLargeInt(cipher);
+        freeLargeInt(message);
+    }
+
+    printf("decryption with CRT:    %.4f s\n", crtTime / rounds);
+    printf("decryption without CRT: %.4f s\n", plainTime / rounds);
+    printf("speedup: %.2f\n", plainTime / crtTime);
+    freeRsaPrivateKey(key);
+    return 0;
+}
+#endif /* #ifndef RSA_NO_MAIN */
@@ -0,0 +1,84 @@
+#ifndef RSA_H
+#define RSA_H
+
+#include "largeInt.h"
+
+
+/* The public exponent used for all generated keys. */
+#define RSA_PUBLIC_EXPONENT 65537U
+
+
+/**
+ ** RsaPublicKey
+ ** The modulus n and the public exponent e. The Montgomery context of
+ ** n is computed once when the key is created and reused for every
+ ** public-key operation.
+ **/
+typedef struct {
+    LargeInt* n;
+    uint32 e;
+    MontgomeryContext* nContext;
+} RsaPublicKey;
+
+
+/**
+ ** RsaPrivateKey
+ ** The public key together with the CRT representation of the private
+ ** exponent d: dP = d mod (p-1), dQ = d mod (q-1) and
+ ** qInv = q^(-1) mod p. The Montgomery contexts of p and q are cached
+ ** as well.
+ **/
+typedef struct {
+    RsaPublicKey publicKey;
+    LargeInt* d;
+    LargeInt* p;
+    LargeInt* q;
+    LargeInt* dP;
+    LargeInt* dQ;
+    LargeInt* qInv;
+    MontgomeryContext* pContext;
+    MontgomeryContext* qContext;
+} RsaPrivateKey;
+
+
+/**
+ ** Generates a new key pair whose modulus has exactly the given number
+ ** of bits. The public exponent is RSA_PUBLIC_EXPONENT.
+ **/
+extern RsaPrivateKey* GenerateRsaKey(uint32 bits);
+/**
+ ** Frees the memory of the given key, including its public part.
+ **/
+extern void freeRsaPrivateKey(RsaPrivateKey* key);
+/**
+ ** Computes message^e mod n. The message has to be less than n.
+ **/
+extern LargeInt* RsaEncrypt(const RsaPublicKey* key, const LargeInt* message);
+/**
+ ** Computes cipher^d mod n with the Chinese Remainder Theorem.
+ **/
+extern LargeInt* RsaDecrypt(const RsaPrivateKey* key, const LargeInt* cipher);
+/**
+ ** Computes cipher^d mod n with the Chinese Remainder Theorem using
+ ** only the constant-time operations of constTime.h, so the running
+ ** time does not depend on the secret values. The cipher has to be
+ ** less than n.
+ **/
+extern LargeInt* RsaDecryptConstantTime(const RsaPrivateKey* key, const LargeInt* cipher);
+/**
+ ** Computes cipher^d mod n with a single exponentiation modulo n.
+ ** This is only meant as a reference for RsaDecrypt.
+ **/
+extern LargeInt* RsaDecryptWithoutCrt(const RsaPrivateKey* key, const LargeInt* cipher);
+/**
+ ** Signs the given message representative, which has to be less
+ ** than n.
+ **/
+extern LargeInt* RsaSign(const RsaPrivateKey* key, const LargeInt* message);
+/**
+ ** Returns TRUE if and only if signature is a valid signature of the
+ ** given message representative.
+ **/
+extern boolean RsaVerify(const RsaPublicKey* key, const LargeInt* message, const LargeInt* signature);
+
+#endif /* #ifndef RSA_H */
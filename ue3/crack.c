@@ -1,6 +1,10 @@
 #include "sha1.h"
+#include "crackEngine.h"
+#include "markov.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
 
 #define PWLENGTH 10
 #define WORDCOUNT 5
@@ -96,6 +100,11 @@ wordVec *loadPasswordList(char* fileName) {
 	uint32 err;
 	char* line = (char*)calloc(40, sizeof(char));
 	f = fopen(fileName, "r");
+	if (f == NULL) {
+		fprintf(stderr, "%s: %s\n", fileName, strerror(errno));
+		free(line);
+		return wv;
+	}
 	err = fscanf(f, "%s", line);
 	while (err != EOF) {
 		add(wv, copyLine(line));
@@ -126,60 +135,370 @@ boolean hashesEqual(uint32 *h1, uint32 *h2) {
 	return TRUE;
 }
 
+/**
+ * Tries all passwords over the given alphabet with up to PWLENGTH
+ * characters on all processors. Returns the password in a freshly
+ * allocated string or NULL.
+ */
 char* bruteForceCrack(uint32* sha1Hash, char* alphabet, uint8 alphabetSize) {
-	char password[PWLENGTH+1];
-	uint8 counter[PWLENGTH];
-	for (int i = 0; i < PWLENGTH; i++)
-	{
-		password[i] = '\0';
-		counter[i] = -1;
-	}
-	password[PWLENGTH+1] = '\0';
-	counter[0] = 0;
-
-	while (1<2)
-	{
-		// Passwort erzeugen
-		uint8 i = 0;
-		while (counter[i] != -1)
-		{
-			password[i] = alphabet[counter[i]];
-			i++;
-		}		
-		
-		// Passwort checken
-		bitBlock* bb = forChars(password);
-		uint32* sha1pw = sha1(bb);
-		freeBitBlock(bb);
-		if(hashesEqual(sha1Hash, sha1pw)) {
-			printf("Das Passwort wurde gefunden, es lautet %s.\n", password);
-			break;
-		}
-		free(sha1pw);
-
-		// Counter erhöhen
-		boolean uebertrag = FALSE;
-		uint8 index = 0;
-		do
-		{
-			if(index > PWLENGTH) break;
-			if(counter[index] == alphabetSize-1) {
-				counter[index] = 0;
-				uebertrag = TRUE;
-			} else {
-				counter[index]++;
-				uebertrag = FALSE;
-			}
-			index++;
-		} while (uebertrag == TRUE);
+	crackTarget target;
+	char* password = NULL;
+	uint32 i;
+
+	target.cracked = FALSE;
+	for (i = 0; i < MAX_DIGEST_WORDS; i++) {
+		target.digest[i] = (i < WORDCOUNT) ? sha1Hash[i] : 0;
+	}
+	if (crackKeyspace(&sha1Algorithm, &target, 1, alphabet, alphabetSize, PWLENGTH, 0) > 0) {
+		printf("Das Passwort wurde gefunden, es lautet %s.\n", target.password);
+		password = copyLine(target.password);
 	}
 	printf("Wenn dir des Programm nix anderweitiges gsagt hat, hat net klappt.\n\n");
+	return password;
+}
+
+/**
+ * Like bruteForceCrack, but tries the passwords in the order of a
+ * Markov model trained on the words in wv, the most probable first.
+ */
+char* markovCrack(uint32* sha1Hash, wordVec *wv, char* alphabet, uint8 alphabetSize) {
+	markovModel *model = trainMarkovModel(wv->words, wv->wordCount, alphabet, alphabetSize);
+	crackTarget target;
+	char* password = NULL;
+	uint32 i;
+
+	if (model == NULL) return NULL;
+	target.cracked = FALSE;
+	for (i = 0; i < MAX_DIGEST_WORDS; i++) {
+		target.digest[i] = (i < WORDCOUNT) ? sha1Hash[i] : 0;
+	}
+	if (crackMarkov(&sha1Algorithm, &target, 1, model, PWLENGTH, MAX_MARKOV_LEVEL, 0) > 0) {
+		printf("Das Passwort wurde gefunden, es lautet %s.\n", target.password);
+		password = copyLine(target.password);
+	}
+	freeMarkovModel(model);
+	return password;
+}
+
+/**
+ * Returns how many candidates bruteForceCrack tries before password.
+ */
+uint64 bruteForcePosition(char* password, char* alphabet, uint32 alphabetSize) {
+	uint64 position = 0;
+	uint64 power = 1;
+	uint32 i, length = 0;
+	while (password[length] != 0) length++;
+	for (i = 1; i < length; i++) {
+		power *= alphabetSize;
+		position += power;
+	}
+	power = 1;
+	for (i = 0; i < length; i++) {
+		uint32 digit = 0;
+		while (alphabet[digit] != password[i]) digit++;
+		position += digit * power;
+		power *= alphabetSize;
+	}
+	return position;
+}
+
+#define MAX_TARGETS 1024
+
+/**
+ * A target of a hash dump together with the algorithm its format
+ * stands for.
+ */
+typedef struct {
+	const hashAlgorithm *alg;
+	crackTarget crack;
+} target;
+
+
+/**
+ * Decodes standard base64 into out, which can hold capacity bytes.
+ * Returns the number of decoded bytes or -1 on malformed input.
+ */
+int decodeBase64(const char *in, unsigned char *out, uint32 capacity) {
+	uint32 bits = 0, bitCount = 0, count = 0;
+	for (; *in != 0 && *in != '='; in++) {
+		int v;
+		if (*in >= 'A' && *in <= 'Z') v = *in - 'A';
+		else if (*in >= 'a' && *in <= 'z') v = *in - 'a' + 26;
+		else if (*in >= '0' && *in <= '9') v = *in - '0' + 52;
+		else if (*in == '+') v = 62;
+		else if (*in == '/') v = 63;
+		else return -1;
+		bits = (bits << 6) | v;
+		bitCount += 6;
+		if (bitCount >= 8) {
+			bitCount -= 8;
+			if (count >= capacity) return -1;
+			out[count++] = (bits >> bitCount) & 0xFF;
+		}
+	}
+	return count;
+}
+
+/**
+ * Parses one line of a hash dump. Supported formats are
+ *   <40 hex digits>                          raw sha-1
+ *   <40 hex digits>:<salt>                   sha1(salt || password)
+ *   sha1:<iterations>:<base64 salt>:<base64 hash>   PBKDF2-HMAC-SHA1
+ * Returns FALSE if the line matches none of them.
+ */
+boolean parseTarget(const char *line, target *t) {
+	hashSalt *salt = &t->crack.salt;
+	uint32 i;
+	memset(t, 0, sizeof(target));
+
+	if (strncmp(line, "sha1:", 5) == 0) {
+		char encodedSalt[2 * MAX_SALT_LENGTH];
+		unsigned char dk[64];
+		char *end;
+		int length;
+		const char *p = line + 5;
+
+		t->alg = &pbkdf2Sha1Algorithm;
+		salt->iterations = strtoul(p, &end, 10);
+		if (*end != ':' || salt->iterations == 0) return FALSE;
+		p = end + 1;
+		for (i = 0; p[i] != ':' && p[i] != 0 && i < sizeof(encodedSalt) - 1; i++) encodedSalt[i] = p[i];
+		if (p[i] != ':') return FALSE;
+		encodedSalt[i] = 0;
+		length = decodeBase64(encodedSalt, salt->bytes, MAX_SALT_LENGTH);
+		if (length < 0) return FALSE;
+		salt->length = length;
+		/* longer derived keys start with the same 20 bytes */
+		if (decodeBase64(p + i + 1, dk, sizeof(dk)) < 20) return FALSE;
+		for (i = 0; i < 20; i++) t->crack.digest[i / 4] = (t->crack.digest[i / 4] << 8) | dk[i];
+		return TRUE;
+	}
+
+	if (!parseHexDigest(line, WORDCOUNT, TRUE, t->crack.digest)) return FALSE;
+	if (line[40] == 0) {
+		t->alg = &sha1Algorithm;
+		return TRUE;
+	}
+	if (line[40] != ':') return FALSE;
+	t->alg = &saltedSha1Algorithm;
+	for (i = 0; line[41 + i] != 0; i++) {
+		if (i >= MAX_SALT_LENGTH) return FALSE;
+		salt->bytes[i] = line[41 + i];
+	}
+	salt->length = i;
+	return TRUE;
+}
+
+/**
+ * Copies the targets of the given algorithm into batch, which has to
+ * hold targetCount entries. Returns their number.
+ */
+uint32 gatherTargets(target *targets, uint32 targetCount, const hashAlgorithm *alg, crackTarget *batch) {
+	uint32 count = 0;
+	uint32 i;
+	for (i = 0; i < targetCount; i++) {
+		if (targets[i].alg == alg) batch[count++] = targets[i].crack;
+	}
+	return count;
+}
+
+/**
+ * Copies the results of gatherTargets back.
+ */
+void scatterTargets(target *targets, uint32 targetCount, const hashAlgorithm *alg, const crackTarget *batch) {
+	uint32 count = 0;
+	uint32 i;
+	for (i = 0; i < targetCount; i++) {
+		if (targets[i].alg == alg) targets[i].crack = batch[count++];
+	}
+}
+
+/* the algorithms that parseTarget knows */
+const hashAlgorithm *dumpAlgorithms[] = {&sha1Algorithm, &saltedSha1Algorithm, &pbkdf2Sha1Algorithm};
+#define DUMP_ALGORITHM_COUNT 3
+
+/**
+ * Tries all passwords over the given alphabet with up to maxLength
+ * characters against all targets, one engine run per algorithm on all
+ * processors. Returns the number of cracked targets.
+ */
+uint32 crackTargets(target *targets, uint32 targetCount, char *alphabet, uint32 alphabetSize, uint32 maxLength) {
+	crackTarget *batch = (crackTarget*)calloc(targetCount, sizeof(crackTarget));
+	uint32 cracked = 0;
+	uint32 i;
+	for (i = 0; i < DUMP_ALGORITHM_COUNT; i++) {
+		uint32 count = gatherTargets(targets, targetCount, dumpAlgorithms[i], batch);
+		if (count == 0) continue;
+		cracked += crackKeyspace(dumpAlgorithms[i], batch, count, alphabet, alphabetSize, maxLength, 0);
+		scatterTargets(targets, targetCount, dumpAlgorithms[i], batch);
+	}
+	free(batch);
+	return cracked;
+}
+
+/**
+ * Tries every word of the given list against all targets. Returns
+ * the number of cracked targets.
+ */
+uint32 crackWithWordList(target *targets, uint32 targetCount, wordVec *wv) {
+	crackTarget *batch = (crackTarget*)calloc(targetCount, sizeof(crackTarget));
+	uint32 cracked = 0;
+	uint32 i, j;
+	for (i = 0; i < DUMP_ALGORITHM_COUNT; i++) {
+		uint32 count = gatherTargets(targets, targetCount, dumpAlgorithms[i], batch);
+		if (count == 0) continue;
+		crackWords(dumpAlgorithms[i], batch, count, wv->words, wv->wordCount, 0);
+		scatterTargets(targets, targetCount, dumpAlgorithms[i], batch);
+	}
+	for (j = 0; j < targetCount; j++) {
+		if (targets[j].crack.cracked) cracked++;
+	}
+	free(batch);
+	return cracked;
+}
+
+/**
+ * Loads one target per line from the given hash dump. Lines that
+ * can not be parsed, e.g. because they are too long, are reported and
+ * skipped as a whole. Returns the number of targets.
+ */
+uint32 loadTargets(char *fileName, target *targets, uint32 capacity) {
+	FILE *f = fopen(fileName, "r");
+	char *line = NULL;
+	size_t lineCapacity = 0;
+	ssize_t length;
+	uint32 lineNumber = 0;
+	uint32 count = 0;
+	if (f == NULL) return 0;
+	while (count < capacity && (length = getline(&line, &lineCapacity, f)) != -1) {
+		lineNumber++;
+		while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) line[--length] = 0;
+		if (length == 0) continue;
+		if (parseTarget(line, &targets[count])) {
+			count++;
+		} else {
+			fprintf(stderr, "%s:%u: kein gueltiges Ziel, Zeile uebersprungen\n", fileName, lineNumber);
+		}
+	}
+	free(line);
+	fclose(f);
+	return count;
+}
 
+void printTargets(target *targets, uint32 targetCount) {
+	uint32 i;
+	for (i = 0; i < targetCount; i++) {
+		const crackTarget *t = &targets[i].crack;
+		if (t->cracked) {
+			printf("%-12s %08x... %s\n", targets[i].alg->name, t->digest[0], t->password);
+		} else {
+			printf("%-12s %08x... nicht gefunden\n", targets[i].alg->name, t->digest[0]);
+		}
+	}
 }
 
-int main() {
-	bitBlock *msg = forChars("asdfgh");
-    uint32* hash = sha1(msg);
+
+/**
+ * Cracks the targets of the given hash dump, first with the words of
+ * the given list, if any, then with all lowercase passwords of up to
+ * four characters.
+ */
+int crackDump(char *dumpName, char *wordListName) {
+	target *targets = (target*)malloc(MAX_TARGETS * sizeof(target));
+	uint32 targetCount = loadTargets(dumpName, targets, MAX_TARGETS);
+	uint32 cracked = 0;
+	if (targetCount == 0) {
+		fprintf(stderr, "%s: keine Ziele gefunden\n", dumpName);
+		free(targets);
+		return 1;
+	}
+	if (wordListName != NULL) {
+		wordVec *wv = loadPasswordList(wordListName);
+		cracked = crackWithWordList(targets, targetCount, wv);
+		freeWordVec(wv);
+	}
+	if (cracked < targetCount) {
+		cracked = crackTargets(targets, targetCount, "abcdefghijklmnopqrstuvwxyz", 26, 4);
+	}
+	printTargets(targets, targetCount);
+	printf("%u von %u Zielen gefunden\n", cracked, targetCount);
+	free(targets);
+	return 0;
+}
+
+
+// Build with
+//   gcc -O2 -pthread crack.c crackEngine.c markov.c sha1.c
+// and run without arguments for the demo, or as
+//   ./a.out dump.txt [wordlist.txt]
+// to crack a hash dump with at most MAX_TARGETS lines.
+int main(int argc, char **argv) {
+	if (argc > 1) return crackDump(argv[1], argc > 2 ? argv[2] : NULL);
+
+	uint32 rfc6070[WORDCOUNT];
+	pbkdf2Sha1((const unsigned char*)"password", 8, (const unsigned char*)"salt", 4, 2, rfc6070);
+	printf("PBKDF2 (RFC 6070, c = 2): ");
+	printWordArrayHex(rfc6070, WORDCOUNT);
+	printf("erwartet:                 ea6c014dc72d6f8ccd1ed92ace1d41f0d8de8957\n");
+
+	char *dump[] = {
+		"a9993e364706816aba3e25717850c26c9cd0d89d",
+		"673d47f39c60c1ebae3a6cb8c2d607a7c50b663c:NaCl",
+		"1bc3447accc3ffa7cc38ab972d1edd0438135573:NaCl",
+		"f00ab5468b199bfbb7bf735323db9633d99a64a5:pepper",
+		"sha1:1000:c2FsdHNhbHQ=:XT0KsJRcJU9DxVkinREvj7rQ4c+HD78z"
+	};
+	target targets[5];
+	uint32 i;
+	for (i = 0; i < 5; i++) parseTarget(dump[i], &targets[i]);
+	crackTargets(targets, 5, "abcdefghijklmnopqrstuvwxyz", 26, 3);
+	printTargets(targets, 5);
+	printf("\n");
+
+	/* one target per algorithm, all for the password "abc" */
+	const hashAlgorithm *algorithms[] = {&sha1Algorithm, &sha256Algorithm, &md5Algorithm, &ntlmAlgorithm};
+	char *abcHashes[] = {
+		"a9993e364706816aba3e25717850c26c9cd0d89d",
+		"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+		"900150983cd24fb0d6963f7d28e17f72",
+		"e0fba38268d0ec66ef1cb452d5885e53"
+	};
+	for (i = 0; i < 4; i++) {
+		crackTarget t;
+		memset(&t, 0, sizeof(t));
+		parseHexDigest(abcHashes[i], algorithms[i]->digestWords, algorithms[i]->bigEndian, t.digest);
+		crackKeyspace(algorithms[i], &t, 1, "abcdefghijklmnopqrstuvwxyz", 26, 4, 0);
+		printf("%-7s %s\n", algorithms[i]->name, t.cracked ? t.password : "nicht gefunden");
+	}
+	printf("\n");
+
+	/* trained on a few common passwords, the model finds similar ones early */
+	char *common[] = {
+		"password", "123456", "12345678", "qwerty", "abc123", "monkey", "letmein", "dragon",
+		"111111", "baseball", "iloveyou", "trustno1", "sunshine", "master", "welcome", "shadow",
+		"ashley", "football", "jesus", "michael", "ninja", "mustang", "password1", "princess",
+		"charlie", "superman", "batman", "hello", "freedom", "whatever", "starwars", "pokemon",
+		"computer", "internet", "samsung", "maggie", "summer", "winter", "secret", "tigger"
+	};
+	char *lowerAndDigits = "abcdefghijklmnopqrstuvwxyz0123456789";
+	wordVec *training = initWordVec();
+	for (i = 0; i < sizeof(common) / sizeof(common[0]); i++) add(training, copyLine(common[i]));
+	markovModel *model = trainMarkovModel(training->words, training->wordCount, lowerAndDigits, 36);
+	uint32 level;
+	uint64 position = markovPosition(model, "hello1", PWLENGTH, &level);
+	printf("hello1: Kandidat %llu nach Markov (Stufe %u), %llu beim Durchzaehlen\n",
+	       position, level, bruteForcePosition("hello1", lowerAndDigits, 36));
+	freeMarkovModel(model);
+	bitBlock *msg = forChars("hello1");
+	uint32* hash = sha1(msg);
+	freeBitBlock(msg);
+	free(markovCrack(hash, training, lowerAndDigits, 36));
+	free(hash);
+	freeWordVec(training);
+	printf("\n");
+
+	msg = forChars("asdfgh");
+    hash = sha1(msg);
     // printWordArrayHex(hash, 5);
     freeBitBlock(msg);
 	bruteForceCrack(hash, "abcdefghijklmnopqrstuvwxyz", 26);
@@ -192,4 +511,4 @@ int main() {
 	int hash2[] = { 0xd27eb556, 0x73c666c0, 0xc12873cc, 0x6ed592bf, 0xe59ff958 };
 	bruteForceCrack(hash2, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789", 62);
 
-}
\ No newline at end of file
+}
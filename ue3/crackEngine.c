@@ -0,0 +1,856 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "crackEngine.h"
+
+/*
+ * Brute-force engine shared by all hash algorithms. The candidate
+ * generator, the target table and the thread pool exist once, while
+ * DEFINE_ALGORITHM stamps out a separate search loop per algorithm in
+ * which the engine's own block function is inlined. The only indirect
+ * call is the one to searchRange, made once per range of RANGE_SIZE
+ * candidates. Salted algorithms share the same pool and hash every
+ * candidate once per distinct salt of the targets, calling the
+ * incremental functions of sha1.c.
+ */
+
+/* number of candidates a worker takes at once */
+#define RANGE_SIZE ((uint64)1 << 16)
+#define SALTED_RANGE_SIZE 64
+#define MAX_THREADS 256
+
+/* the block functions are too large for the inlining heuristics of gcc */
+#define BLOCK_FUNCTION_INLINE static inline __attribute__((always_inline))
+
+#define ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+
+/* ---------------------------------------------------------------- */
+/* block functions                                                  */
+/* ---------------------------------------------------------------- */
+
+static const uint32 sha1InitialState[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+#define SHA1_STEP(F, K)                                   \
+	z = ROTL(a, 5) + (F) + e + (K) + w[t];                \
+	e = d;                                                \
+	d = c;                                                \
+	c = ROTL(b, 30);                                      \
+	b = a;                                                \
+	a = z
+
+/*
+ * Same compression as sha1Compress in sha1.c, kept here so that it is
+ * inlined into the search loops instead of being called per candidate.
+ * The engine hashes every candidate from the initial state.
+ */
+BLOCK_FUNCTION_INLINE void sha1Block(const uint32 *block, uint32 *digest) {
+	uint32 w[80];
+	uint32 a = sha1InitialState[0];
+	uint32 b = sha1InitialState[1];
+	uint32 c = sha1InitialState[2];
+	uint32 d = sha1InitialState[3];
+	uint32 e = sha1InitialState[4];
+	uint32 t, z;
+
+	for (t = 0; t < 16; t++) w[t] = block[t];
+	for (t = 16; t < 80; t++) w[t] = ROTL(w[t - 3] ^ w[t - 8] ^ w[t - 14] ^ w[t - 16], 1);
+
+	for (t = 0; t < 20; t++) { SHA1_STEP((b & c) | (~b & d), 0x5A827999); }
+	for (; t < 40; t++) { SHA1_STEP(b ^ c ^ d, 0x6ED9EBA1); }
+	for (; t < 60; t++) { SHA1_STEP((b & c) | (b & d) | (c & d), 0x8F1BBCDC); }
+	for (; t < 80; t++) { SHA1_STEP(b ^ c ^ d, 0xCA62C1D6); }
+
+	digest[0] = a + sha1InitialState[0];
+	digest[1] = b + sha1InitialState[1];
+	digest[2] = c + sha1InitialState[2];
+	digest[3] = d + sha1InitialState[3];
+	digest[4] = e + sha1InitialState[4];
+}
+
+
+static const uint32 sha256K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32 sha256Init[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+BLOCK_FUNCTION_INLINE void sha256Block(const uint32 *block, uint32 *digest) {
+	uint32 w[64];
+	uint32 s[8];
+	uint32 t;
+
+	for (t = 0; t < 16; t++) w[t] = block[t];
+	for (t = 16; t < 64; t++) {
+		uint32 s0 = ROTR(w[t - 15], 7) ^ ROTR(w[t - 15], 18) ^ (w[t - 15] >> 3);
+		uint32 s1 = ROTR(w[t - 2], 17) ^ ROTR(w[t - 2], 19) ^ (w[t - 2] >> 10);
+		w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+	}
+	for (t = 0; t < 8; t++) s[t] = sha256Init[t];
+
+	for (t = 0; t < 64; t++) {
+		uint32 e = s[4];
+		uint32 a = s[0];
+		uint32 t1 = s[7] + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & s[5]) ^ (~e & s[6])) + sha256K[t] + w[t];
+		uint32 t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & s[1]) ^ (a & s[2]) ^ (s[1] & s[2]));
+		s[7] = s[6];
+		s[6] = s[5];
+		s[5] = s[4];
+		s[4] = s[3] + t1;
+		s[3] = s[2];
+		s[2] = s[1];
+		s[1] = s[0];
+		s[0] = t1 + t2;
+	}
+	for (t = 0; t < 8; t++) digest[t] = s[t] + sha256Init[t];
+}
+
+
+static const uint32 md5K[64] = {
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static const uint32 md5Shift[16] = {7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21};
+
+BLOCK_FUNCTION_INLINE void md5Block(const uint32 *block, uint32 *digest) {
+	uint32 a = 0x67452301, b = 0xefcdab89, c = 0x98badcfe, d = 0x10325476;
+	uint32 t, f, g;
+
+	for (t = 0; t < 64; t++) {
+		if (t < 16) {
+			f = (b & c) | (~b & d);
+			g = t;
+		} else if (t < 32) {
+			f = (d & b) | (~d & c);
+			g = (5 * t + 1) % 16;
+		} else if (t < 48) {
+			f = b ^ c ^ d;
+			g = (3 * t + 5) % 16;
+		} else {
+			f = c ^ (b | ~d);
+			g = (7 * t) % 16;
+		}
+		f = f + a + md5K[t] + block[g];
+		a = d;
+		d = c;
+		c = b;
+		b = b + ROTL(f, md5Shift[(t / 16) * 4 + t % 4]);
+	}
+	digest[0] = a + 0x67452301;
+	digest[1] = b + 0xefcdab89;
+	digest[2] = c + 0x98badcfe;
+	digest[3] = d + 0x10325476;
+}
+
+
+static const uint32 md4Shift[12] = {3, 7, 11, 19, 3, 5, 9, 13, 3, 9, 11, 15};
+static const uint32 md4Order[3][16] = {
+	{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+	{0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15},
+	{0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15}
+};
+
+BLOCK_FUNCTION_INLINE void md4Block(const uint32 *block, uint32 *digest) {
+	uint32 a = 0x67452301, b = 0xefcdab89, c = 0x98badcfe, d = 0x10325476;
+	uint32 t, f;
+
+	for (t = 0; t < 48; t++) {
+		uint32 round = t / 16;
+		if (round == 0) f = ((b & c) | (~b & d));
+		else if (round == 1) f = ((b & c) | (b & d) | (c & d)) + 0x5a827999;
+		else f = (b ^ c ^ d) + 0x6ed9eba1;
+		f = ROTL(a + f + block[md4Order[round][t % 16]], md4Shift[round * 4 + t % 4]);
+		a = d;
+		d = c;
+		c = b;
+		b = f;
+	}
+	digest[0] = a + 0x67452301;
+	digest[1] = b + 0xefcdab89;
+	digest[2] = c + 0x98badcfe;
+	digest[3] = d + 0x10325476;
+}
+
+
+/* ---------------------------------------------------------------- */
+/* message layouts                                                  */
+/* ---------------------------------------------------------------- */
+
+/* byte i of the message in big-endian and little-endian words */
+#define BE_SHIFT(i) ((3 - ((i) % 4)) * 8)
+#define LE_SHIFT(i) (((i) % 4) * 8)
+
+#define SET_BYTE(block, i, c, SHIFT) \
+	((block)[(i) / 4] = ((block)[(i) / 4] & ~(0xFFU << SHIFT(i))) | ((uint32)(unsigned char)(c) << SHIFT(i)))
+
+/* one-block padding for a message of the given number of bytes */
+static inline void prepareBigEndian(uint32 *block, uint32 bytes) {
+	memset(block, 0, 16 * sizeof(uint32));
+	block[bytes / 4] = 0x80U << BE_SHIFT(bytes);
+	block[15] = bytes * 8;
+}
+
+static inline void prepareLittleEndian(uint32 *block, uint32 bytes) {
+	memset(block, 0, 16 * sizeof(uint32));
+	block[bytes / 4] = 0x80U << LE_SHIFT(bytes);
+	block[14] = bytes * 8;
+}
+
+#define SET_CHAR_BE(block, i, c) SET_BYTE(block, i, c, BE_SHIFT)
+#define SET_CHAR_LE(block, i, c) SET_BYTE(block, i, c, LE_SHIFT)
+/* NTLM hashes the UTF-16LE encoding, character i is byte 2i */
+#define SET_CHAR_UTF16(block, i, c) SET_BYTE(block, 2 * (i), c, LE_SHIFT)
+#define PREPARE_BE(block, length) prepareBigEndian(block, length)
+#define PREPARE_LE(block, length) prepareLittleEndian(block, length)
+#define PREPARE_UTF16(block, length) prepareLittleEndian(block, 2 * (length))
+
+
+/* ---------------------------------------------------------------- */
+/* target table                                                     */
+/* ---------------------------------------------------------------- */
+
+/**
+ * Open-addressing set of target digests keyed by their first word.
+ * keys duplicates that word next to the slot, so the common miss is
+ * decided without touching the targets. For a salted algorithm there
+ * is one table per distinct salt, holding the targets with that salt.
+ */
+struct targetTable {
+	crackTarget *targets;
+	uint32 digestWords;
+	// NULL for unsalted algorithms
+	const hashSalt *salt;
+	// target index + 1 for each slot, 0 marks an empty slot
+	uint32 *slots;
+	uint32 *keys;
+	uint32 mask;
+	uint32 remaining;
+	pthread_mutex_t lock;
+};
+
+static inline uint32 tableSlot(const targetTable *t, uint32 key) {
+	return (key * 0x9E3779B1U) & t->mask;
+}
+
+/* orders salts by length, iteration count and bytes */
+static int compareSalts(const hashSalt *a, const hashSalt *b) {
+	if (a->length != b->length) return a->length < b->length ? -1 : 1;
+	if (a->iterations != b->iterations) return a->iterations < b->iterations ? -1 : 1;
+	return memcmp(a->bytes, b->bytes, a->length);
+}
+
+static int compareTargetSalts(const void *a, const void *b) {
+	return compareSalts(&(*(crackTarget* const*)a)->salt, &(*(crackTarget* const*)b)->salt);
+}
+
+/**
+ * Builds the table of the given members of targets, all of which are
+ * uncracked and, if salt is not NULL, have that salt.
+ */
+static targetTable *initTargetTable(crackTarget *targets, crackTarget **members, uint32 memberCount,
+                                    uint32 digestWords, const hashSalt *salt) {
+	targetTable *t = (targetTable*)calloc(1, sizeof(targetTable));
+	uint32 size = 16;
+	uint32 i;
+	while (size < 2 * memberCount) size *= 2;
+	t->targets = targets;
+	t->digestWords = digestWords;
+	t->salt = salt;
+	t->slots = (uint32*)calloc(size, sizeof(uint32));
+	t->keys = (uint32*)calloc(size, sizeof(uint32));
+	t->mask = size - 1;
+	pthread_mutex_init(&t->lock, NULL);
+
+	for (i = 0; i < memberCount; i++) {
+		uint32 s = tableSlot(t, members[i]->digest[0]);
+		while (t->slots[s] != 0) s = (s + 1) & t->mask;
+		t->slots[s] = (uint32)(members[i] - targets) + 1;
+		t->keys[s] = members[i]->digest[0];
+	}
+	t->remaining = memberCount;
+	return t;
+}
+
+static void freeTargetTable(targetTable *t) {
+	pthread_mutex_destroy(&t->lock);
+	free(t->slots);
+	free(t->keys);
+	free(t);
+}
+
+/**
+ * Stores one table per distinct salt of the uncracked targets in
+ * tables, which has to hold targetCount entries, or a single table if
+ * the algorithm is unsalted. The targets are sorted by salt once, so
+ * every table is built from and sized by its own group.
+ * Returns the number of tables.
+ */
+static uint32 initTargetTables(const hashAlgorithm *alg, crackTarget *targets, uint32 targetCount,
+                               targetTable **tables) {
+	crackTarget **members = (crackTarget**)malloc((targetCount + 1) * sizeof(crackTarget*));
+	uint32 memberCount = 0;
+	uint32 tableCount = 0;
+	uint32 i, j;
+	for (i = 0; i < targetCount; i++) {
+		if (!targets[i].cracked) members[memberCount++] = &targets[i];
+	}
+	if (!alg->salted) {
+		tables[tableCount++] = initTargetTable(targets, members, memberCount, alg->digestWords, NULL);
+	} else {
+		qsort(members, memberCount, sizeof(crackTarget*), compareTargetSalts);
+		for (i = 0; i < memberCount; i = j) {
+			for (j = i + 1; j < memberCount && compareSalts(&members[j]->salt, &members[i]->salt) == 0; j++);
+			tables[tableCount++] = initTargetTable(targets, members + i, j - i, alg->digestWords,
+			                                       &members[i]->salt);
+		}
+	}
+	free(members);
+	return tableCount;
+}
+
+static inline boolean mayContain(const targetTable *t, uint32 key) {
+	uint32 s = tableSlot(t, key);
+	while (t->slots[s] != 0) {
+		if (t->keys[s] == key) return TRUE;
+		s = (s + 1) & t->mask;
+	}
+	return FALSE;
+}
+
+/**
+ * Marks every target with the given digest as cracked by candidate.
+ * Returns the number of newly cracked targets.
+ */
+static uint32 recordMatches(targetTable *t, const uint32 *digest, const char *candidate, uint32 length) {
+	uint32 found = 0;
+	uint32 s = tableSlot(t, digest[0]);
+
+	pthread_mutex_lock(&t->lock);
+	while (t->slots[s] != 0) {
+		crackTarget *target = &t->targets[t->slots[s] - 1];
+		if (!target->cracked && memcmp(target->digest, digest, t->digestWords * sizeof(uint32)) == 0) {
+			memcpy(target->password, candidate, length);
+			target->password[length] = '\0';
+			target->cracked = TRUE;
+			__atomic_sub_fetch(&t->remaining, 1, __ATOMIC_RELAXED);
+			found++;
+		}
+		s = (s + 1) & t->mask;
+	}
+	pthread_mutex_unlock(&t->lock);
+	return found;
+}
+
+
+/* ---------------------------------------------------------------- */
+/* markov chain                                                     */
+/* ---------------------------------------------------------------- */
+
+/**
+ * The place of a candidate in its slice: for every position the rank
+ * of the chosen character among the successors of the previous one,
+ * the index of that character and the level that is left for this and
+ * all following positions.
+ */
+typedef struct {
+	uint32 rank[MAX_CANDIDATE_LENGTH];
+	uint32 character[MAX_CANDIDATE_LENGTH];
+	uint32 remaining[MAX_CANDIDATE_LENGTH];
+} markovState;
+
+static inline const uint64 *suffixCounts(const markovChain *c, uint32 length, uint32 state) {
+	return &c->suffixCounts[((uint64)length * (c->alphabetSize + 1) + state) * (MAX_MARKOV_LEVEL + 1)];
+}
+
+uint64 markovSliceSize(const markovSlice *slice) {
+	const markovChain *c = slice->chain;
+	if (slice->length > MAX_CANDIDATE_LENGTH || slice->level > MAX_MARKOV_LEVEL) return 0;
+	return suffixCounts(c, slice->length, c->alphabetSize)[slice->level];
+}
+
+/**
+ * Chooses the first successor with rank k or higher at position pos
+ * that still allows to complete the candidate. Returns FALSE if there
+ * is none.
+ */
+static inline boolean markovChoose(const markovSlice *slice, uint32 pos, uint32 k, markovState *st, char *candidate) {
+	const markovChain *c = slice->chain;
+	uint32 previous = (pos == 0) ? c->alphabetSize : st->character[pos - 1];
+	const unsigned char *successors = &c->successors[previous * c->alphabetSize];
+	const unsigned char *levels = &c->levels[previous * c->alphabetSize];
+	uint32 remaining = st->remaining[pos];
+
+	/* the last character has to use up the remaining level exactly */
+	if (pos + 1 == slice->length) {
+		while (k < c->alphabetSize && levels[k] < remaining) k++;
+		if (k == c->alphabetSize || levels[k] != remaining) return FALSE;
+	} else {
+		const uint64 *counts = suffixCounts(c, slice->length - pos - 1, 0);
+		for (; k < c->alphabetSize && levels[k] <= remaining; k++) {
+			if (counts[successors[k] * (MAX_MARKOV_LEVEL + 1) + remaining - levels[k]] != 0) break;
+		}
+		if (k == c->alphabetSize || levels[k] > remaining) return FALSE;
+		st->remaining[pos + 1] = remaining - levels[k];
+	}
+	st->rank[pos] = k;
+	st->character[pos] = successors[k];
+	candidate[pos] = c->alphabet[successors[k]];
+	return TRUE;
+}
+
+/**
+ * Sets up st and candidate for candidate index of the slice.
+ */
+static void markovSeek(const markovSlice *slice, uint64 index, markovState *st, char *candidate) {
+	const markovChain *c = slice->chain;
+	uint32 pos;
+
+	st->remaining[0] = slice->level;
+	for (pos = 0; pos < slice->length; pos++) {
+		uint32 previous = (pos == 0) ? c->alphabetSize : st->character[pos - 1];
+		const unsigned char *successors = &c->successors[previous * c->alphabetSize];
+		const unsigned char *levels = &c->levels[previous * c->alphabetSize];
+		uint32 remaining = st->remaining[pos];
+		uint32 k;
+
+		/* skip the successors whose suffixes all come before index */
+		for (k = 0; k + 1 < c->alphabetSize && levels[k] <= remaining; k++) {
+			uint64 n = suffixCounts(c, slice->length - pos - 1, successors[k])[remaining - levels[k]];
+			if (index < n) break;
+			index -= n;
+		}
+		st->rank[pos] = k;
+		st->character[pos] = successors[k];
+		candidate[pos] = c->alphabet[successors[k]];
+		if (pos + 1 < slice->length) st->remaining[pos + 1] = remaining - levels[k];
+	}
+}
+
+/**
+ * Advances to the next candidate of the slice: the last position that
+ * can take a later successor does so, and all positions after it take
+ * their first possible successor. Returns the first position that
+ * changed.
+ */
+static inline uint32 markovNext(const markovSlice *slice, markovState *st, char *candidate) {
+	uint32 pos, p;
+	for (pos = slice->length; pos-- > 0;) {
+		if (markovChoose(slice, pos, st->rank[pos] + 1, st, candidate)) {
+			for (p = pos + 1; p < slice->length; p++) markovChoose(slice, p, 0, st, candidate);
+			return pos;
+		}
+	}
+	return slice->length;
+}
+
+
+/* ---------------------------------------------------------------- */
+/* candidate generator and specialized search loops                 */
+/* ---------------------------------------------------------------- */
+
+static inline void candidateFromIndex(const keyspace *ks, uint64 index, uint32 *counter) {
+	uint32 i;
+	for (i = 0; i < ks->length; i++) {
+		counter[i] = index % ks->alphabetSize;
+		index /= ks->alphabetSize;
+	}
+}
+
+/**
+ * Defines the searchRange, searchMarkov and hash functions of an
+ * algorithm. Only the changed characters of the padded block are
+ * rewritten between two candidates, and BLOCK_FUNCTION as well as the
+ * step to the next candidate are inlined into the loops.
+ */
+#define DEFINE_ALGORITHM(NAME, DIGEST_WORDS, BLOCK_FUNCTION, PREPARE, SET_CHAR)                       \
+static uint32 NAME##SearchRange(const keyspace *ks, uint64 first, uint64 count, targetTable *table) { \
+	uint32 block[16];                                                                                 \
+	uint32 digest[MAX_DIGEST_WORDS];                                                                  \
+	uint32 counter[MAX_CANDIDATE_LENGTH];                                                             \
+	char candidate[MAX_CANDIDATE_LENGTH];                                                             \
+	uint32 found = 0;                                                                                 \
+	uint64 n;                                                                                         \
+	uint32 i;                                                                                         \
+                                                                                                      \
+	PREPARE(block, ks->length);                                                                       \
+	candidateFromIndex(ks, first, counter);                                                           \
+	for (i = 0; i < ks->length; i++) SET_CHAR(block, i, ks->alphabet[counter[i]]);                    \
+                                                                                                      \
+	for (n = 0; n < count; n++) {                                                                     \
+		BLOCK_FUNCTION(block, digest);                                                                \
+		if (mayContain(table, digest[0])) {                                                           \
+			for (i = 0; i < ks->length; i++) candidate[i] = ks->alphabet[counter[i]];                 \
+			found += recordMatches(table, digest, candidate, ks->length);                             \
+		}                                                                                             \
+		for (i = 0; i < ks->length; i++) {                                                            \
+			if (++counter[i] < ks->alphabetSize) {                                                    \
+				SET_CHAR(block, i, ks->alphabet[counter[i]]);                                         \
+				break;                                                                                \
+			}                                                                                         \
+			counter[i] = 0;                                                                           \
+			SET_CHAR(block, i, ks->alphabet[0]);                                                      \
+		}                                                                                             \
+	}                                                                                                 \
+	return found;                                                                                     \
+}                                                                                                     \
+                                                                                                      \
+static uint32 NAME##SearchMarkov(const markovSlice *slice, uint64 first, uint64 count,               \
+                                 targetTable *table) {                                                \
+	uint32 block[16];                                                                                 \
+	uint32 digest[MAX_DIGEST_WORDS];                                                                  \
+	markovState state;                                                                                \
+	char candidate[MAX_CANDIDATE_LENGTH];                                                             \
+	uint32 found = 0;                                                                                 \
+	uint64 n;                                                                                         \
+	uint32 i;                                                                                         \
+                                                                                                      \
+	PREPARE(block, slice->length);                                                                    \
+	markovSeek(slice, first, &state, candidate);                                                      \
+	for (i = 0; i < slice->length; i++) SET_CHAR(block, i, candidate[i]);                             \
+                                                                                                      \
+	for (n = 0; n < count; n++) {                                                                     \
+		BLOCK_FUNCTION(block, digest);                                                                \
+		if (mayContain(table, digest[0])) found += recordMatches(table, digest, candidate, slice->length); \
+		if (n + 1 == count) break;                                                                    \
+		for (i = markovNext(slice, &state, candidate); i < slice->length; i++) {                      \
+			SET_CHAR(block, i, candidate[i]);                                                         \
+		}                                                                                             \
+	}                                                                                                 \
+	return found;                                                                                     \
+}                                                                                                     \
+                                                                                                      \
+static void NAME##Hash(const hashSalt *salt, const char *password, uint32 length, uint32 *digest) {   \
+	uint32 block[16];                                                                                 \
+	uint32 i;                                                                                         \
+	(void)salt;                                                                                       \
+	PREPARE(block, length);                                                                           \
+	for (i = 0; i < length; i++) SET_CHAR(block, i, password[i]);                                     \
+	BLOCK_FUNCTION(block, digest);                                                                    \
+}
+
+DEFINE_ALGORITHM(sha1, 5, sha1Block, PREPARE_BE, SET_CHAR_BE)
+DEFINE_ALGORITHM(sha256, 8, sha256Block, PREPARE_BE, SET_CHAR_BE)
+DEFINE_ALGORITHM(md5, 4, md5Block, PREPARE_LE, SET_CHAR_LE)
+DEFINE_ALGORITHM(ntlm, 4, md4Block, PREPARE_UTF16, SET_CHAR_UTF16)
+
+
+/**
+ * Defines the search functions of a salted algorithm, which hash every
+ * candidate with the salt of the table using HASH_FUNCTION. The
+ * message no longer fits a single prepared block, but a salted hash
+ * costs at least as much as the bookkeeping around it anyway.
+ */
+#define DEFINE_SALTED_ALGORITHM(NAME, HASH_FUNCTION)                                                  \
+static uint32 NAME##SearchRange(const keyspace *ks, uint64 first, uint64 count, targetTable *table) { \
+	uint32 digest[MAX_DIGEST_WORDS];                                                                  \
+	uint32 counter[MAX_CANDIDATE_LENGTH];                                                             \
+	char candidate[MAX_CANDIDATE_LENGTH];                                                             \
+	uint32 found = 0;                                                                                 \
+	uint64 n;                                                                                         \
+	uint32 i;                                                                                         \
+                                                                                                      \
+	candidateFromIndex(ks, first, counter);                                                           \
+	for (i = 0; i < ks->length; i++) candidate[i] = ks->alphabet[counter[i]];                         \
+                                                                                                      \
+	for (n = 0; n < count && __atomic_load_n(&table->remaining, __ATOMIC_RELAXED) > 0; n++) {         \
+		HASH_FUNCTION(table->salt, candidate, ks->length, digest);                                    \
+		if (mayContain(table, digest[0])) found += recordMatches(table, digest, candidate, ks->length); \
+		for (i = 0; i < ks->length; i++) {                                                            \
+			if (++counter[i] < ks->alphabetSize) {                                                    \
+				candidate[i] = ks->alphabet[counter[i]];                                              \
+				break;                                                                                \
+			}                                                                                         \
+			counter[i] = 0;                                                                           \
+			candidate[i] = ks->alphabet[0];                                                           \
+		}                                                                                             \
+	}                                                                                                 \
+	return found;                                                                                     \
+}                                                                                                     \
+                                                                                                      \
+static uint32 NAME##SearchMarkov(const markovSlice *slice, uint64 first, uint64 count,               \
+                                 targetTable *table) {                                                \
+	uint32 digest[MAX_DIGEST_WORDS];                                                                  \
+	markovState state;                                                                                \
+	char candidate[MAX_CANDIDATE_LENGTH];                                                             \
+	uint32 found = 0;                                                                                 \
+	uint64 n;                                                                                         \
+                                                                                                      \
+	markovSeek(slice, first, &state, candidate);                                                      \
+	for (n = 0; n < count && __atomic_load_n(&table->remaining, __ATOMIC_RELAXED) > 0; n++) {         \
+		HASH_FUNCTION(table->salt, candidate, slice->length, digest);                                 \
+		if (mayContain(table, digest[0])) found += recordMatches(table, digest, candidate, slice->length); \
+		if (n + 1 == count) break;                                                                    \
+		markovNext(slice, &state, candidate);                                                         \
+	}                                                                                                 \
+	return found;                                                                                     \
+}
+
+static void saltedSha1Hash(const hashSalt *salt, const char *password, uint32 length, uint32 *digest) {
+	sha1Context ctx;
+	sha1Init(&ctx);
+	sha1Update(&ctx, salt->bytes, salt->length);
+	sha1Update(&ctx, (const unsigned char*)password, length);
+	sha1Final(&ctx, digest);
+}
+
+static void pbkdf2Sha1Hash(const hashSalt *salt, const char *password, uint32 length, uint32 *digest) {
+	pbkdf2Sha1((const unsigned char*)password, length, salt->bytes, salt->length, salt->iterations, digest);
+}
+
+DEFINE_SALTED_ALGORITHM(saltedSha1, saltedSha1Hash)
+DEFINE_SALTED_ALGORITHM(pbkdf2Sha1, pbkdf2Sha1Hash)
+
+const hashAlgorithm sha1Algorithm = {"sha1", 5, TRUE, FALSE, sha1Hash, sha1SearchRange, sha1SearchMarkov};
+const hashAlgorithm sha256Algorithm = {"sha256", 8, TRUE, FALSE, sha256Hash, sha256SearchRange, sha256SearchMarkov};
+const hashAlgorithm md5Algorithm = {"md5", 4, FALSE, FALSE, md5Hash, md5SearchRange, md5SearchMarkov};
+const hashAlgorithm ntlmAlgorithm = {"ntlm", 4, FALSE, FALSE, ntlmHash, ntlmSearchRange, ntlmSearchMarkov};
+const hashAlgorithm saltedSha1Algorithm = {"sha1-salted", 5, TRUE, TRUE, saltedSha1Hash,
+                                           saltedSha1SearchRange, saltedSha1SearchMarkov};
+const hashAlgorithm pbkdf2Sha1Algorithm = {"pbkdf2-sha1", 5, TRUE, TRUE, pbkdf2Sha1Hash,
+                                           pbkdf2Sha1SearchRange, pbkdf2Sha1SearchMarkov};
+
+
+const hashAlgorithm *findHashAlgorithm(const char *name) {
+	const hashAlgorithm *all[] = {&sha1Algorithm, &sha256Algorithm, &md5Algorithm, &ntlmAlgorithm,
+	                              &saltedSha1Algorithm, &pbkdf2Sha1Algorithm};
+	uint32 i;
+	for (i = 0; i < sizeof(all) / sizeof(all[0]); i++) {
+		if (strcmp(all[i]->name, name) == 0) return all[i];
+	}
+	return NULL;
+}
+
+
+/* ---------------------------------------------------------------- */
+/* thread pool                                                      */
+/* ---------------------------------------------------------------- */
+
+typedef struct {
+	const hashAlgorithm *alg;
+	keyspace ks;
+	// if not NULL, the candidates are those of the slices instead of
+	// ks, one slice after the other
+	const markovSlice *slices;
+	// index after the last candidate of every slice
+	uint64 *sliceEnds;
+	uint32 sliceCount;
+	// if not NULL, the candidates are these words instead
+	char **words;
+	// the job covers the indices from nextRange up to end
+	uint64 end;
+	uint64 nextRange;
+	uint64 rangeSize;
+	// one table per salt, see initTargetTables
+	targetTable **tables;
+	uint32 tableCount;
+} crackJob;
+
+/**
+ * Tries the words first to first + count - 1. Word lists are short
+ * compared to a keyspace, so this goes through the generic hash
+ * function.
+ */
+static uint32 searchWords(const hashAlgorithm *alg, char **words, uint64 first, uint64 count, targetTable *table) {
+	uint32 digest[MAX_DIGEST_WORDS];
+	uint32 found = 0;
+	uint64 n;
+	for (n = first; n < first + count; n++) {
+		uint32 length = strlen(words[n]);
+		if (length == 0 || length > MAX_CANDIDATE_LENGTH) continue;
+		alg->hash(table->salt, words[n], length, digest);
+		if (mayContain(table, digest[0])) found += recordMatches(table, digest, words[n], length);
+	}
+	return found;
+}
+
+/**
+ * Tries the candidates first to first + count - 1 of the slices of
+ * the job, which may span several slices.
+ */
+static void searchSlices(const crackJob *job, uint64 first, uint64 count, targetTable *table) {
+	uint64 end = first + count;
+	uint32 low = 0, high = job->sliceCount;
+
+	/* the first slice that ends after first */
+	while (low < high) {
+		uint32 middle = (low + high) / 2;
+		if (job->sliceEnds[middle] <= first) low = middle + 1;
+		else high = middle;
+	}
+	for (; low < job->sliceCount && first < end; low++) {
+		uint64 sliceFirst = (low == 0) ? 0 : job->sliceEnds[low - 1];
+		uint64 stop = (job->sliceEnds[low] < end) ? job->sliceEnds[low] : end;
+		if (stop > first) job->alg->searchMarkov(&job->slices[low], first - sliceFirst, stop - first, table);
+		first = stop;
+	}
+}
+
+static uint32 remainingTargets(const crackJob *job) {
+	uint32 remaining = 0;
+	uint32 i;
+	for (i = 0; i < job->tableCount; i++) remaining += __atomic_load_n(&job->tables[i]->remaining, __ATOMIC_RELAXED);
+	return remaining;
+}
+
+static void *crackWorker(void *arg) {
+	crackJob *job = (crackJob*)arg;
+	uint32 i;
+	while (remainingTargets(job) > 0) {
+		uint64 first = __atomic_fetch_add(&job->nextRange, job->rangeSize, __ATOMIC_RELAXED);
+		if (first >= job->end) break;
+		uint64 count = (job->end - first < job->rangeSize) ? job->end - first : job->rangeSize;
+		for (i = 0; i < job->tableCount; i++) {
+			targetTable *table = job->tables[i];
+			if (__atomic_load_n(&table->remaining, __ATOMIC_RELAXED) == 0) continue;
+			if (job->words != NULL) searchWords(job->alg, job->words, first, count, table);
+			else if (job->slices != NULL) searchSlices(job, first, count, table);
+			else job->alg->searchRange(&job->ks, first, count, table);
+		}
+	}
+	return NULL;
+}
+
+static uint32 normalizeThreadCount(uint32 threadCount) {
+	if (threadCount == 0) threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+	if (threadCount < 1) threadCount = 1;
+	if (threadCount > MAX_THREADS) threadCount = MAX_THREADS;
+	return threadCount;
+}
+
+static void runJob(crackJob *job, uint32 threadCount) {
+	pthread_t threads[MAX_THREADS];
+	uint32 i;
+	for (i = 0; i < threadCount; i++) pthread_create(&threads[i], NULL, crackWorker, job);
+	for (i = 0; i < threadCount; i++) pthread_join(threads[i], NULL);
+}
+
+static uint32 countCracked(const crackTarget *targets, uint32 targetCount) {
+	uint32 cracked = 0;
+	uint32 i;
+	for (i = 0; i < targetCount; i++) {
+		if (targets[i].cracked) cracked++;
+	}
+	return cracked;
+}
+
+/**
+ * Sets up a job without candidates. A salted hash costs far more per
+ * candidate, so the ranges are smaller to keep all threads busy.
+ */
+static void initJob(crackJob *job, const hashAlgorithm *alg, crackTarget *targets, uint32 targetCount) {
+	memset(job, 0, sizeof(crackJob));
+	job->alg = alg;
+	job->rangeSize = alg->salted ? SALTED_RANGE_SIZE : RANGE_SIZE;
+	job->tables = (targetTable**)malloc((targetCount + 1) * sizeof(targetTable*));
+	job->tableCount = initTargetTables(alg, targets, targetCount, job->tables);
+}
+
+static void freeJob(crackJob *job) {
+	uint32 i;
+	for (i = 0; i < job->tableCount; i++) freeTargetTable(job->tables[i]);
+	free(job->tables);
+}
+
+
+uint32 crackKeyspace(const hashAlgorithm *alg, crackTarget *targets, uint32 targetCount,
+                     const char *alphabet, uint32 alphabetSize, uint32 maxLength,
+                     uint32 threadCount) {
+	uint64 total = 1;
+	uint32 length;
+	crackJob job;
+
+	threadCount = normalizeThreadCount(threadCount);
+	if (maxLength > MAX_CANDIDATE_LENGTH) maxLength = MAX_CANDIDATE_LENGTH;
+
+	initJob(&job, alg, targets, targetCount);
+	job.ks.alphabet = alphabet;
+	job.ks.alphabetSize = alphabetSize;
+	for (length = 1; length <= maxLength && remainingTargets(&job) > 0; length++) {
+		/* stop before the number of candidates overflows */
+		if (total > ~(uint64)0 / alphabetSize) break;
+		total *= alphabetSize;
+		job.ks.length = length;
+		job.nextRange = 0;
+		job.end = total;
+		runJob(&job, threadCount);
+	}
+
+	freeJob(&job);
+	return countCracked(targets, targetCount);
+}
+
+
+uint32 crackRange(const hashAlgorithm *alg, crackTarget *targets, uint32 targetCount,
+                  const keyspace *ks, uint64 first, uint64 count, uint32 threadCount) {
+	uint32 before = countCracked(targets, targetCount);
+	crackJob job;
+
+	initJob(&job, alg, targets, targetCount);
+	job.ks = *ks;
+	job.nextRange = first;
+	job.end = first + count;
+	if (remainingTargets(&job) > 0 && count > 0) runJob(&job, normalizeThreadCount(threadCount));
+
+	freeJob(&job);
+	return countCracked(targets, targetCount) - before;
+}
+
+
+uint32 crackSlices(const hashAlgorithm *alg, crackTarget *targets, uint32 targetCount,
+                   const markovSlice *slices, uint32 sliceCount, uint32 threadCount) {
+	uint32 before = countCracked(targets, targetCount);
+	uint64 total = 0;
+	uint32 i;
+	crackJob job;
+
+	initJob(&job, alg, targets, targetCount);
+	job.slices = slices;
+	job.sliceCount = sliceCount;
+	job.sliceEnds = (uint64*)malloc((sliceCount + 1) * sizeof(uint64));
+	for (i = 0; i < sliceCount; i++) {
+		uint64 size = markovSliceSize(&slices[i]);
+		/* saturate, the slices beyond 2^64 - 1 candidates are never reached */
+		total = (total + size < total) ? ~(uint64)0 : total + size;
+		job.sliceEnds[i] = total;
+	}
+	job.end = total;
+	if (remainingTargets(&job) > 0 && total > 0) runJob(&job, normalizeThreadCount(threadCount));
+
+	free(job.sliceEnds);
+	freeJob(&job);
+	return countCracked(targets, targetCount) - before;
+}
+
+
+uint32 crackWords(const hashAlgorithm *alg, crackTarget *targets, uint32 targetCount,
+                  char **words, uint32 wordCount, uint32 threadCount) {
+	uint32 before = countCracked(targets, targetCount);
+	crackJob job;
+
+	initJob(&job, alg, targets, targetCount);
+	job.words = words;
+	job.rangeSize = SALTED_RANGE_SIZE;
+	job.end = wordCount;
+	if (remainingTargets(&job) > 0 && wordCount > 0) runJob(&job, normalizeThreadCount(threadCount));
+
+	freeJob(&job);
+	return countCracked(targets, targetCount) - before;
+}
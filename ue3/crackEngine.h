@@ -0,0 +1,153 @@
+#ifndef CRACKENGINE_H
+#define CRACKENGINE_H
+
+#include "sha1.h"
+
+
+#define MAX_DIGEST_WORDS 8
+/* every candidate has to fit into a single block of each algorithm */
+#define MAX_CANDIDATE_LENGTH 16
+#define MAX_SALT_LENGTH 64
+
+
+/**
+ * A keyspace of all strings of the given length over the alphabet.
+ * Candidate i is the number i written in base alphabetSize with the
+ * least significant digit first, so ranges of indices can be handed
+ * out independently.
+**/
+typedef struct {
+	const char *alphabet;
+	uint32 alphabetSize;
+	uint32 length;
+} keyspace;
+
+/**
+ * The salt of a target of a salted algorithm and, for key derivation
+ * functions, the iteration count. Unsalted algorithms ignore it.
+**/
+typedef struct {
+	unsigned char bytes[MAX_SALT_LENGTH];
+	uint32 length;
+	uint32 iterations;
+} hashSalt;
+
+typedef struct {
+	uint32 digest[MAX_DIGEST_WORDS];
+	hashSalt salt;
+	boolean cracked;
+	char password[MAX_CANDIDATE_LENGTH + 1];
+} crackTarget;
+
+typedef struct targetTable targetTable;
+
+/* transition levels are 2 * -log2(p), rounded down and capped here */
+#define MAX_TRANSITION_LEVEL 15
+#define MAX_MARKOV_LEVEL (MAX_CANDIDATE_LENGTH * MAX_TRANSITION_LEVEL)
+
+/**
+ * The tables from which probability-ordered candidates are enumerated,
+ * see markov.h. The states are the character indices and the start
+ * state alphabetSize. successors and levels list the alphabetSize
+ * successors of every state in order of ascending level, and
+ * suffixCounts holds for every length up to MAX_CANDIDATE_LENGTH,
+ * state and level up to MAX_MARKOV_LEVEL the number of strings of that
+ * length which may follow the state and whose levels sum up to the
+ * level. The engine steps through these tables itself, so that the
+ * step is inlined into the search loop of every algorithm.
+**/
+typedef struct {
+	const char *alphabet;
+	uint32 alphabetSize;
+	const unsigned char *successors;
+	const unsigned char *levels;
+	const uint64 *suffixCounts;
+} markovChain;
+
+/**
+ * The candidates of one length and level of a chain.
+**/
+typedef struct {
+	const markovChain *chain;
+	uint32 length;
+	uint32 level;
+} markovSlice;
+
+/**
+ * The interface of a hash algorithm. hash computes a single digest
+ * and is meant for tests and for building targets, searchRange runs
+ * the specialized cracking loop over count candidates starting at
+ * index first and returns the number of newly cracked targets.
+ * searchMarkov does the same for the candidates of a slice.
+ * Digests are stored in the native word order of the algorithm, i.e.
+ * big-endian words for the sha family and little-endian words for
+ * md5 and md4. Salted algorithms get the salt of the targets in the
+ * table, the others ignore it and may be given NULL.
+**/
+typedef struct {
+	const char *name;
+	uint32 digestWords;
+	boolean bigEndian;
+	boolean salted;
+	void (*hash)(const hashSalt *salt, const char *password, uint32 length, uint32 *digest);
+	uint32 (*searchRange)(const keyspace *ks, uint64 first, uint64 count, targetTable *table);
+	uint32 (*searchMarkov)(const markovSlice *slice, uint64 first, uint64 count, targetTable *table);
+} hashAlgorithm;
+
+
+extern const hashAlgorithm sha1Algorithm;
+extern const hashAlgorithm sha256Algorithm;
+extern const hashAlgorithm md5Algorithm;
+extern const hashAlgorithm ntlmAlgorithm;
+/* sha1(salt || password) */
+extern const hashAlgorithm saltedSha1Algorithm;
+/* the first 20 bytes of PBKDF2-HMAC-SHA1(password, salt, iterations) */
+extern const hashAlgorithm pbkdf2Sha1Algorithm;
+
+/**
+ * Returns the algorithm with the given name ("sha1", "sha256", "md5",
+ * "ntlm", "sha1-salted" or "pbkdf2-sha1") or NULL.
+**/
+extern const hashAlgorithm *findHashAlgorithm(const char *name);
+/**
+ * Tries all passwords over the alphabet with 1 to maxLength characters
+ * against the targets, using threadCount threads (0 means one per
+ * processor). Targets of a salted algorithm may have different salts,
+ * every candidate is hashed once per distinct salt. Stops as soon as
+ * all targets are cracked and returns the number of cracked targets.
+**/
+extern uint32 crackKeyspace(const hashAlgorithm *alg, crackTarget *targets, uint32 targetCount,
+                            const char *alphabet, uint32 alphabetSize, uint32 maxLength,
+                            uint32 threadCount);
+
+/**
+ * Tries the count candidates of the keyspace starting at index first,
+ * which is how a share of a larger search is processed. Targets that
+ * are already marked as cracked are skipped. Returns the number of
+ * newly cracked targets.
+**/
+extern uint32 crackRange(const hashAlgorithm *alg, crackTarget *targets, uint32 targetCount,
+                         const keyspace *ks, uint64 first, uint64 count, uint32 threadCount);
+
+/**
+ * Returns the number of candidates in slice, saturated at 2^64 - 1.
+**/
+extern uint64 markovSliceSize(const markovSlice *slice);
+/**
+ * Tries the candidates of the given slices one after another in a
+ * single run of the thread pool, so that slices of a few candidates
+ * cost no more than a range of the same size. Returns the number of
+ * newly cracked targets.
+**/
+extern uint32 crackSlices(const hashAlgorithm *alg, crackTarget *targets, uint32 targetCount,
+                          const markovSlice *slices, uint32 sliceCount, uint32 threadCount);
+
+/**
+ * Tries the given 0-terminated words, skipping the ones with more than
+ * MAX_CANDIDATE_LENGTH characters. Returns the number of newly cracked
+ * targets.
+**/
+extern uint32 crackWords(const hashAlgorithm *alg, crackTarget *targets, uint32 targetCount,
+                         char **words, uint32 wordCount, uint32 threadCount);
+
+#endif /* #ifndef CRACKENGINE_H */
@@ -0,0 +1,750 @@
+#define _GNU_SOURCE
+#include "crackEngine.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+/*
+ * Distributes a brute-force search over several processes or machines.
+ *
+ *   crackd serve [-u path | [-h host] -p port] [-s leaseSize] [-t seconds]
+ *                [-w workers [-j threads]] algorithm alphabet maxLength target...
+ *   crackd work  [-u path | [-h host] -p port] [-j threads]
+ *
+ * The coordinator (serve) splits the keyspace into leases of leaseSize
+ * candidates and hands them to the workers that connect to it over a
+ * Unix socket or TCP. A lease that is not finished within the timeout,
+ * or whose worker disconnects, is handed out again. -w forks the given
+ * number of local workers, so
+ *   crackd serve -u /tmp/crack.sock -w 4 sha1 abcdefghijklmnopqrstuvwxyz 6 <hash>
+ * runs a complete search on one machine. TCP listens on 127.0.0.1
+ * unless another host (e.g. 0.0.0.0) is given.
+ *
+ * A target is the digest in hex. For sha1-salted it is followed by
+ * :<salt in hex>, for pbkdf2-sha1 by :<salt in hex>:<iterations>, e.g.
+ *   crackd serve -u /tmp/crack.sock -w 4 pbkdf2-sha1 abc 4 <digest>:73616c74:1000
+ * Salted searches hash far fewer candidates per second, so their
+ * default lease is smaller.
+ *
+ * The protocol consists of text lines. After connecting, a worker
+ * receives
+ *   JOB <algorithm> <alphabet in hex> <targetCount>
+ *   TARGET <target>                 (targetCount times, as given to serve)
+ * and then repeatedly sends GET, which the coordinator answers with
+ *   CRACKED <target> <password in hex>   (targets cracked since the last GET)
+ *   LEASE <id> <length> <first> <count>  or  WAIT  or  DONE
+ * For a lease, the worker reports every password it finds with
+ *   FOUND <target> <password in hex>
+ * followed by FINISHED <id>, which only counts from the worker that
+ * holds the lease. The coordinator verifies found passwords itself and
+ * closes all connections when it is done.
+ *
+ * Build with
+ *   gcc -O2 -pthread crackd.c crackEngine.c sha1.c -o crackd
+ */
+
+#define MAX_CLIENTS 256
+#define MAX_TARGETS 4096
+#define MESSAGE_LENGTH 1024
+/* digest, salt and iteration count of a target in text form */
+#define MAX_TARGET_LENGTH 256
+#define DEFAULT_LEASE_SIZE ((uint64)1 << 26)
+#define DEFAULT_SALTED_LEASE_SIZE ((uint64)1 << 14)
+#define DEFAULT_LEASE_TIMEOUT 300
+
+
+typedef struct {
+	const char *unixPath;
+	const char *host;
+	const char *port;
+} address;
+
+typedef struct {
+	uint32 length;
+	uint64 first;
+	uint64 count;
+	// id of the client holding the lease, 0 if it is free
+	uint32 owner;
+	// id of the client the lease was handed to most recently
+	uint32 lastOwner;
+	time_t deadline;
+	boolean done;
+} lease;
+
+typedef struct {
+	int fd;
+	// unique for the whole run, unlike fd
+	uint32 id;
+	char buffer[MESSAGE_LENGTH];
+	uint32 used;
+	// number of entries of the crack log already sent to this client
+	uint32 knownCracks;
+} client;
+
+typedef struct {
+	const hashAlgorithm *alg;
+	const char *alphabet;
+	uint32 alphabetSize;
+	uint32 maxLength;
+	crackTarget targets[MAX_TARGETS];
+	// the targets as given on the command line
+	char *targetHex[MAX_TARGETS];
+	uint32 targetCount;
+	// target indices in the order in which they were cracked
+	uint32 crackLog[MAX_TARGETS];
+	uint32 crackedCount;
+
+	lease *leases;
+	uint32 leaseCount;
+	uint32 leaseCapacity;
+	// all leases below this index are done
+	uint32 oldestOpen;
+	// leases that have to be handed out again
+	uint32 *retries;
+	uint32 retryCount;
+	// the first candidate that has not been leased yet
+	uint32 nextLength;
+	uint64 nextFirst;
+	uint64 leaseSize;
+	uint32 leaseTimeout;
+
+	client clients[MAX_CLIENTS];
+	uint32 clientCount;
+	uint32 nextClientId;
+} coordinator;
+
+
+static coordinator coord;
+
+
+/* ---------------------------------------------------------------- */
+/* helpers                                                          */
+/* ---------------------------------------------------------------- */
+
+void toHex(const char *s, uint32 length, char *hex) {
+	uint32 i;
+	for (i = 0; i < length; i++) sprintf(&hex[2 * i], "%02x", (unsigned char)s[i]);
+	hex[2 * length] = '\0';
+}
+
+/**
+ * Decodes hex into s, which has room for maxLength characters and the
+ * terminating 0. Returns the decoded length or -1 if hex is malformed.
+ */
+int fromHex(const char *hex, char *s, uint32 maxLength) {
+	uint32 length = strlen(hex);
+	uint32 i;
+	if (length % 2 != 0 || length / 2 > maxLength) return -1;
+	for (i = 0; i < length / 2; i++) {
+		unsigned int byte;
+		if (sscanf(&hex[2 * i], "%2x", &byte) != 1) return -1;
+		s[i] = (char)byte;
+	}
+	s[length / 2] = '\0';
+	return length / 2;
+}
+
+/**
+ * Parses a target of the given algorithm: the digest in hex, followed
+ * by :<salt in hex> for salted algorithms and by :<iterations> for
+ * PBKDF2. Returns FALSE if text is no such target.
+ */
+boolean parseTarget(const hashAlgorithm *alg, const char *text, crackTarget *t) {
+	const char *saltHex = strchr(text, ':');
+	const char *iterations;
+	char hex[2 * MAX_SALT_LENGTH + 1];
+	char salt[MAX_SALT_LENGTH + 1];
+	uint32 length = saltHex == NULL ? strlen(text) : (uint32)(saltHex - text);
+	int saltLength;
+	char *end;
+
+	memset(t, 0, sizeof(crackTarget));
+	if (strlen(text) >= MAX_TARGET_LENGTH) return FALSE;
+	if (length != alg->digestWords * 8 || !parseHexDigest(text, alg->digestWords, alg->bigEndian, t->digest)) {
+		return FALSE;
+	}
+	if (!alg->salted) return saltHex == NULL;
+	if (saltHex == NULL) return FALSE;
+
+	saltHex++;
+	iterations = strchr(saltHex, ':');
+	length = iterations == NULL ? strlen(saltHex) : (uint32)(iterations - saltHex);
+	if (length == 0 || length >= sizeof(hex)) return FALSE;
+	memcpy(hex, saltHex, length);
+	hex[length] = '\0';
+	saltLength = fromHex(hex, salt, MAX_SALT_LENGTH);
+	if (saltLength < 0) return FALSE;
+	memcpy(t->salt.bytes, salt, saltLength);
+	t->salt.length = saltLength;
+
+	/* only PBKDF2 has an iteration count */
+	if (alg != &pbkdf2Sha1Algorithm) return iterations == NULL;
+	if (iterations == NULL) return FALSE;
+	t->salt.iterations = strtoul(iterations + 1, &end, 10);
+	return *end == '\0' && t->salt.iterations > 0;
+}
+
+/**
+ * Writes a formatted line to fd. Returns FALSE if the connection is
+ * broken.
+ */
+boolean sendLine(int fd, const char *format, ...) {
+	char line[MESSAGE_LENGTH];
+	va_list args;
+	int length, written;
+	int offset = 0;
+
+	va_start(args, format);
+	length = vsnprintf(line, sizeof(line) - 1, format, args);
+	va_end(args);
+	if (length < 0 || length >= (int)sizeof(line) - 1) return FALSE;
+	line[length++] = '\n';
+	while (offset < length) {
+		written = write(fd, &line[offset], length - offset);
+		if (written < 0 && errno == EINTR) continue;
+		if (written <= 0) return FALSE;
+		offset += written;
+	}
+	return TRUE;
+}
+
+/**
+ * Returns the number of candidates of the given length, or 0 if that
+ * number does not fit into 64 bits.
+ */
+uint64 keyspaceSize(uint32 alphabetSize, uint32 length) {
+	uint64 total = 1;
+	uint32 i;
+	for (i = 0; i < length; i++) {
+		if (total > ~(uint64)0 / alphabetSize) return 0;
+		total *= alphabetSize;
+	}
+	return total;
+}
+
+/**
+ * Opens a listening socket if listening is TRUE, otherwise connects to
+ * the address. Returns the socket or -1.
+ */
+int openSocket(const address *addr, boolean listening) {
+	int fd = -1;
+
+	if (addr->unixPath != NULL) {
+		struct sockaddr_un sa;
+		memset(&sa, 0, sizeof(sa));
+		sa.sun_family = AF_UNIX;
+		if (strlen(addr->unixPath) >= sizeof(sa.sun_path)) {
+			errno = ENAMETOOLONG;
+			return -1;
+		}
+		strcpy(sa.sun_path, addr->unixPath);
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0) return -1;
+		if (listening) {
+			unlink(addr->unixPath);
+			if (bind(fd, (struct sockaddr*)&sa, sizeof(sa)) == 0 && listen(fd, MAX_CLIENTS) == 0) return fd;
+		} else {
+			if (connect(fd, (struct sockaddr*)&sa, sizeof(sa)) == 0) return fd;
+		}
+	} else {
+		struct addrinfo hints, *result, *ai;
+		int one = 1;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		if (getaddrinfo(addr->host, addr->port, &hints, &result) != 0) {
+			errno = EHOSTUNREACH;
+			return -1;
+		}
+		for (ai = result; ai != NULL; ai = ai->ai_next) {
+			fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+			if (fd < 0) continue;
+			if (listening) {
+				setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+				if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, MAX_CLIENTS) == 0) break;
+			} else {
+				if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+			}
+			close(fd);
+			fd = -1;
+		}
+		freeaddrinfo(result);
+		return fd;
+	}
+	close(fd);
+	return -1;
+}
+
+
+/* ---------------------------------------------------------------- */
+/* worker                                                           */
+/* ---------------------------------------------------------------- */
+
+/**
+ * Connects to the coordinator and works on leases until it reports
+ * that the search is over. Returns the exit status.
+ */
+int runWorker(const address *addr, uint32 threadCount) {
+	static crackTarget targets[MAX_TARGETS];
+	static boolean reported[MAX_TARGETS];
+	char algorithm[32], alphabetHex[MESSAGE_LENGTH], alphabet[MESSAGE_LENGTH];
+	char *line = NULL;
+	size_t lineCapacity = 0;
+	const hashAlgorithm *alg;
+	uint32 targetCount, i;
+	int alphabetSize;
+	FILE *in;
+	int fd;
+
+	/* the coordinator may still be starting up */
+	for (i = 0; (fd = openSocket(addr, FALSE)) < 0 && i < 50; i++) usleep(100000);
+	if (fd < 0) {
+		fprintf(stderr, "crackd: cannot connect: %s\n", strerror(errno));
+		return 1;
+	}
+	in = fdopen(fd, "r");
+
+	if (getline(&line, &lineCapacity, in) < 0 ||
+	    sscanf(line, "JOB %31s %1023s %u", algorithm, alphabetHex, &targetCount) != 3 ||
+	    (alg = findHashAlgorithm(algorithm)) == NULL ||
+	    (alphabetSize = fromHex(alphabetHex, alphabet, 256)) <= 0 ||
+	    targetCount > MAX_TARGETS) {
+		fprintf(stderr, "crackd: invalid job\n");
+		return 1;
+	}
+	for (i = 0; i < targetCount; i++) {
+		char target[MAX_TARGET_LENGTH];
+		if (getline(&line, &lineCapacity, in) < 0 || sscanf(line, "TARGET %255s", target) != 1 ||
+		    !parseTarget(alg, target, &targets[i])) {
+			fprintf(stderr, "crackd: invalid target\n");
+			return 1;
+		}
+	}
+
+	while (sendLine(fd, "GET")) {
+		uint32 id, length, target;
+		uint64 first, count;
+		char passwordHex[MESSAGE_LENGTH];
+
+		if (getline(&line, &lineCapacity, in) < 0) break;
+		/* passwords found by others come before the answer to GET */
+		while (strncmp(line, "CRACKED ", 8) == 0) {
+			if (sscanf(line, "CRACKED %u %1023s", &target, passwordHex) == 2 && target < targetCount &&
+			    fromHex(passwordHex, targets[target].password, MAX_CANDIDATE_LENGTH) >= 0) {
+				targets[target].cracked = TRUE;
+				reported[target] = TRUE;
+			}
+			if (getline(&line, &lineCapacity, in) < 0) line[0] = '\0';
+		}
+
+		if (strncmp(line, "WAIT", 4) == 0) {
+			sleep(1);
+		} else if (sscanf(line, "LEASE %u %u %llu %llu", &id, &length, &first, &count) == 4 &&
+		           length >= 1 && length <= MAX_CANDIDATE_LENGTH) {
+			keyspace ks;
+			ks.alphabet = alphabet;
+			ks.alphabetSize = alphabetSize;
+			ks.length = length;
+			crackRange(alg, targets, targetCount, &ks, first, count, threadCount);
+			for (i = 0; i < targetCount; i++) {
+				if (!targets[i].cracked || reported[i]) continue;
+				toHex(targets[i].password, strlen(targets[i].password), passwordHex);
+				if (!sendLine(fd, "FOUND %u %s", i, passwordHex)) break;
+				reported[i] = TRUE;
+			}
+			if (!sendLine(fd, "FINISHED %u", id)) break;
+		} else {
+			/* DONE or a broken connection */
+			break;
+		}
+	}
+	free(line);
+	fclose(in);
+	return 0;
+}
+
+
+/* ---------------------------------------------------------------- */
+/* coordinator                                                      */
+/* ---------------------------------------------------------------- */
+
+boolean allCracked(void) {
+	return coord.crackedCount == coord.targetCount;
+}
+
+boolean keyspaceExhausted(void) {
+	return coord.nextLength > coord.maxLength && coord.retryCount == 0 && coord.oldestOpen == coord.leaseCount;
+}
+
+/**
+ * Marks lease index as free so that the next GET hands it out again.
+ */
+void reclaimLease(uint32 index) {
+	coord.leases[index].owner = 0;
+	coord.retries[coord.retryCount++] = index;
+}
+
+/**
+ * Returns the index of the lease for the client with the given id, or
+ * -1 if all of the keyspace is leased.
+ */
+int assignLease(uint32 owner) {
+	lease *l;
+	uint64 total;
+
+	while (coord.retryCount > 0) {
+		uint32 index = coord.retries[--coord.retryCount];
+		if (coord.leases[index].done) continue;
+		coord.leases[index].owner = owner;
+		coord.leases[index].lastOwner = owner;
+		coord.leases[index].deadline = time(NULL) + coord.leaseTimeout;
+		return index;
+	}
+
+	if (coord.nextLength > coord.maxLength) return -1;
+	total = keyspaceSize(coord.alphabetSize, coord.nextLength);
+	if (total == 0) {
+		coord.nextLength = coord.maxLength + 1;
+		return -1;
+	}
+	if (coord.leaseCount >= coord.leaseCapacity) {
+		coord.leaseCapacity = (coord.leaseCapacity == 0) ? 1024 : coord.leaseCapacity * 2;
+		coord.leases = (lease*)realloc(coord.leases, coord.leaseCapacity * sizeof(lease));
+		coord.retries = (uint32*)realloc(coord.retries, coord.leaseCapacity * sizeof(uint32));
+		if (coord.leases == NULL || coord.retries == NULL) {
+			fprintf(stderr, "crackd: could not grow the lease table\n");
+			exit(1);
+		}
+	}
+	l = &coord.leases[coord.leaseCount];
+	l->length = coord.nextLength;
+	l->first = coord.nextFirst;
+	l->count = (total - coord.nextFirst < coord.leaseSize) ? total - coord.nextFirst : coord.leaseSize;
+	l->owner = owner;
+	l->lastOwner = owner;
+	l->deadline = time(NULL) + coord.leaseTimeout;
+	l->done = FALSE;
+
+	coord.nextFirst += l->count;
+	if (coord.nextFirst == total) {
+		coord.nextLength++;
+		coord.nextFirst = 0;
+	}
+	return coord.leaseCount++;
+}
+
+void finishLease(uint32 index) {
+	coord.leases[index].done = TRUE;
+	while (coord.oldestOpen < coord.leaseCount && coord.leases[coord.oldestOpen].done) coord.oldestOpen++;
+}
+
+/**
+ * Handles FINISHED from client c. Only the client that holds the lease
+ * may finish it, or the one that held it last if it expired and has
+ * not been handed out again. Any other report is rejected, and the
+ * range stays in the retry queue or with its current holder.
+ */
+void reportFinished(const client *c, uint32 index) {
+	lease *l = &coord.leases[index];
+	if (l->done) return;
+	if (l->owner == c->id || (l->owner == 0 && l->lastOwner == c->id)) {
+		finishLease(index);
+		return;
+	}
+	fprintf(stderr, "crackd: rejected FINISHED %u from a worker that does not hold the lease\n", index);
+}
+
+/**
+ * Hands out leases again whose deadline has passed or whose owner has
+ * disconnected (owner is then that client's id, otherwise 0).
+ */
+void reclaimLeases(uint32 disconnectedOwner) {
+	time_t now = time(NULL);
+	uint32 i;
+	for (i = coord.oldestOpen; i < coord.leaseCount; i++) {
+		lease *l = &coord.leases[i];
+		if (l->done || l->owner == 0) continue;
+		if (l->owner == disconnectedOwner || (disconnectedOwner == 0 && l->deadline < now)) {
+			fprintf(stderr, "crackd: lease %u (length %u, %llu+%llu) %s\n", i, l->length, l->first,
+			        l->count, disconnectedOwner == 0 ? "expired" : "lost its worker");
+			reclaimLease(i);
+		}
+	}
+}
+
+/**
+ * Checks a password reported by a worker and records it.
+ */
+void recordFound(uint32 target, const char *passwordHex) {
+	char password[MAX_CANDIDATE_LENGTH + 1];
+	uint32 digest[MAX_DIGEST_WORDS];
+	int length;
+
+	if (target >= coord.targetCount || coord.targets[target].cracked) return;
+	length = fromHex(passwordHex, password, MAX_CANDIDATE_LENGTH);
+	if (length < 0) return;
+	coord.alg->hash(&coord.targets[target].salt, password, length, digest);
+	if (memcmp(digest, coord.targets[target].digest, coord.alg->digestWords * sizeof(uint32)) != 0) {
+		fprintf(stderr, "crackd: rejected wrong password for %s\n", coord.targetHex[target]);
+		return;
+	}
+	strcpy(coord.targets[target].password, password);
+	coord.targets[target].cracked = TRUE;
+	coord.crackLog[coord.crackedCount++] = target;
+	printf("%s  %s\n", coord.targetHex[target], password);
+	fflush(stdout);
+}
+
+/**
+ * Answers a GET: first the passwords the client does not know yet,
+ * then a lease, WAIT or DONE.
+ */
+boolean answerGet(client *c) {
+	int index;
+
+	while (c->knownCracks < coord.crackedCount) {
+		uint32 target = coord.crackLog[c->knownCracks++];
+		char hex[2 * MAX_CANDIDATE_LENGTH + 1];
+		toHex(coord.targets[target].password, strlen(coord.targets[target].password), hex);
+		if (!sendLine(c->fd, "CRACKED %u %s", target, hex)) return FALSE;
+	}
+	if (allCracked()) return sendLine(c->fd, "DONE");
+
+	index = assignLease(c->id);
+	if (index >= 0) {
+		lease *l = &coord.leases[index];
+		return sendLine(c->fd, "LEASE %u %u %llu %llu", index, l->length, l->first, l->count);
+	}
+	/* everything is leased, but some leases may still come back */
+	return sendLine(c->fd, keyspaceExhausted() ? "DONE" : "WAIT");
+}
+
+/**
+ * Handles a complete line from a client. Returns FALSE if the client
+ * has to be dropped.
+ */
+boolean handleLine(client *c, const char *line) {
+	char passwordHex[MESSAGE_LENGTH];
+	uint32 id;
+
+	if (strcmp(line, "GET") == 0) return answerGet(c);
+	if (sscanf(line, "FOUND %u %1023s", &id, passwordHex) == 2) {
+		recordFound(id, passwordHex);
+		return TRUE;
+	}
+	if (sscanf(line, "FINISHED %u", &id) == 1) {
+		if (id < coord.leaseCount) reportFinished(c, id);
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/**
+ * Reads what the client sent and handles all complete lines. Returns
+ * FALSE if the connection is closed or broken.
+ */
+boolean readClient(client *c) {
+	ssize_t count = read(c->fd, &c->buffer[c->used], sizeof(c->buffer) - 1 - c->used);
+	char *start, *end;
+
+	if (count <= 0) return FALSE;
+	c->used += count;
+	c->buffer[c->used] = '\0';
+	start = c->buffer;
+	while ((end = strchr(start, '\n')) != NULL) {
+		*end = '\0';
+		if (end > start && end[-1] == '\r') end[-1] = '\0';
+		if (!handleLine(c, start)) return FALSE;
+		start = end + 1;
+	}
+	c->used -= start - c->buffer;
+	memmove(c->buffer, start, c->used);
+	/* a line that does not fit into the buffer is never valid */
+	return c->used < sizeof(c->buffer) - 1;
+}
+
+boolean acceptClient(int listenFd) {
+	char alphabetHex[2 * 256 + 1];
+	client *c;
+	uint32 i;
+	int fd = accept(listenFd, NULL, NULL);
+
+	if (fd < 0) return FALSE;
+	if (coord.clientCount >= MAX_CLIENTS) {
+		close(fd);
+		return FALSE;
+	}
+	c = &coord.clients[coord.clientCount];
+	memset(c, 0, sizeof(client));
+	c->fd = fd;
+	c->id = ++coord.nextClientId;
+
+	toHex(coord.alphabet, coord.alphabetSize, alphabetHex);
+	if (!sendLine(fd, "JOB %s %s %u", coord.alg->name, alphabetHex, coord.targetCount)) {
+		close(fd);
+		return FALSE;
+	}
+	for (i = 0; i < coord.targetCount; i++) {
+		if (!sendLine(fd, "TARGET %s", coord.targetHex[i])) {
+			close(fd);
+			return FALSE;
+		}
+	}
+	coord.clientCount++;
+	return TRUE;
+}
+
+void dropClient(uint32 index) {
+	close(coord.clients[index].fd);
+	reclaimLeases(coord.clients[index].id);
+	coord.clients[index] = coord.clients[--coord.clientCount];
+}
+
+/**
+ * Serves leases until all targets are cracked or the whole keyspace is
+ * searched.
+ */
+void runCoordinator(int listenFd) {
+	struct pollfd fds[MAX_CLIENTS + 1];
+	time_t lastCheck = time(NULL);
+	uint32 i;
+
+	while (!allCracked() && !keyspaceExhausted()) {
+		fds[0].fd = listenFd;
+		fds[0].events = POLLIN;
+		for (i = 0; i < coord.clientCount; i++) {
+			fds[i + 1].fd = coord.clients[i].fd;
+			fds[i + 1].events = POLLIN;
+		}
+		if (poll(fds, coord.clientCount + 1, 1000) < 0 && errno != EINTR) {
+			perror("crackd: poll");
+			break;
+		}
+
+		/* backwards, because dropClient moves the last client */
+		for (i = coord.clientCount; i > 0; i--) {
+			if (fds[i].revents != 0 && !readClient(&coord.clients[i - 1])) dropClient(i - 1);
+		}
+		if (fds[0].revents & POLLIN) acceptClient(listenFd);
+
+		if (time(NULL) != lastCheck) {
+			lastCheck = time(NULL);
+			reclaimLeases(0);
+		}
+	}
+	for (i = 0; i < coord.clientCount; i++) close(coord.clients[i].fd);
+	coord.clientCount = 0;
+}
+
+void printSummary(void) {
+	uint32 i;
+	printf("\n%u of %u targets cracked", coord.crackedCount, coord.targetCount);
+	if (!allCracked()) printf(" after searching all passwords up to length %u", coord.maxLength);
+	printf("\n");
+	for (i = 0; i < coord.targetCount; i++) {
+		printf("%s  %s\n", coord.targetHex[i], coord.targets[i].cracked ? coord.targets[i].password : "-");
+	}
+}
+
+
+/* ---------------------------------------------------------------- */
+/* command line                                                     */
+/* ---------------------------------------------------------------- */
+
+void usage(void) {
+	fprintf(stderr, "usage: crackd serve [-u path | [-h host] -p port] [-s leaseSize] [-t seconds]\n");
+	fprintf(stderr, "                    [-w workers [-j threads]] algorithm alphabet maxLength target...\n");
+	fprintf(stderr, "       crackd work  [-u path | [-h host] -p port] [-j threads]\n");
+	fprintf(stderr, "algorithms: sha1, sha256, md5, ntlm, sha1-salted, pbkdf2-sha1\n");
+	fprintf(stderr, "targets:    <digest>, <digest>:<salt> for sha1-salted,\n");
+	fprintf(stderr, "            <digest>:<salt>:<iterations> for pbkdf2-sha1, all in hex\n");
+	exit(1);
+}
+
+int main(int argc, char **argv) {
+	address addr = {NULL, "127.0.0.1", NULL};
+	uint32 localWorkers = 0;
+	long threadCount = -1;
+	boolean serve;
+	int listenFd;
+	int i;
+
+	if (argc < 2) usage();
+	if (strcmp(argv[1], "serve") == 0) serve = TRUE;
+	else if (strcmp(argv[1], "work") == 0) serve = FALSE;
+	else usage();
+
+	coord.leaseSize = 0;
+	coord.leaseTimeout = DEFAULT_LEASE_TIMEOUT;
+	for (i = 2; i < argc && argv[i][0] == '-'; i++) {
+		if (i + 1 >= argc) usage();
+		if (strcmp(argv[i], "-u") == 0) addr.unixPath = argv[++i];
+		else if (strcmp(argv[i], "-h") == 0) addr.host = argv[++i];
+		else if (strcmp(argv[i], "-p") == 0) addr.port = argv[++i];
+		else if (strcmp(argv[i], "-j") == 0) threadCount = atol(argv[++i]);
+		else if (serve && strcmp(argv[i], "-s") == 0) {
+			coord.leaseSize = strtoull(argv[++i], NULL, 0);
+			if (coord.leaseSize == 0) usage();
+		}
+		else if (serve && strcmp(argv[i], "-t") == 0) coord.leaseTimeout = atol(argv[++i]);
+		else if (serve && strcmp(argv[i], "-w") == 0) localWorkers = atol(argv[++i]);
+		else usage();
+	}
+	if ((addr.unixPath == NULL) == (addr.port == NULL)) usage();
+	signal(SIGPIPE, SIG_IGN);
+
+	if (!serve) {
+		if (i != argc) usage();
+		return runWorker(&addr, threadCount < 0 ? 0 : threadCount);
+	}
+
+	if (argc - i < 4) usage();
+	coord.alg = findHashAlgorithm(argv[i]);
+	coord.alphabet = argv[i + 1];
+	coord.alphabetSize = strlen(coord.alphabet);
+	coord.maxLength = atol(argv[i + 2]);
+	if (coord.alg == NULL || coord.alphabetSize == 0 || coord.alphabetSize > 256) usage();
+	if (coord.maxLength > MAX_CANDIDATE_LENGTH) coord.maxLength = MAX_CANDIDATE_LENGTH;
+	if (coord.leaseSize == 0) coord.leaseSize = coord.alg->salted ? DEFAULT_SALTED_LEASE_SIZE : DEFAULT_LEASE_SIZE;
+	for (i += 3; i < argc && coord.targetCount < MAX_TARGETS; i++) {
+		if (!parseTarget(coord.alg, argv[i], &coord.targets[coord.targetCount])) {
+			fprintf(stderr, "crackd: %s is not a %s target\n", argv[i], coord.alg->name);
+			return 1;
+		}
+		coord.targetHex[coord.targetCount++] = argv[i];
+	}
+	coord.nextLength = 1;
+
+	listenFd = openSocket(&addr, TRUE);
+	if (listenFd < 0) {
+		fprintf(stderr, "crackd: cannot listen: %s\n", strerror(errno));
+		return 1;
+	}
+	/* local workers use one thread each unless told otherwise */
+	for (i = 0; i < (int)localWorkers; i++) {
+		if (fork() == 0) {
+			close(listenFd);
+			_exit(runWorker(&addr, threadCount < 0 ? 1 : threadCount));
+		}
+	}
+
+	runCoordinator(listenFd);
+	close(listenFd);
+	if (addr.unixPath != NULL) unlink(addr.unixPath);
+	while (wait(NULL) > 0);
+
+	printSummary();
+	free(coord.leases);
+	free(coord.retries);
+	return allCracked() ? 0 : 2;
+}
@@ -0,0 +1,218 @@
+#include <stdlib.h>
+#include <string.h>
+#include "markov.h"
+
+/*
+ * Probability-ordered candidates. This file trains the model and
+ * builds the tables of its markovChain, the engine enumerates the
+ * candidates from them.
+ */
+
+#define SQRT2 1.4142135623730951
+#define START_STATE(m) ((m)->alphabetSize)
+
+
+struct markovModel {
+	char alphabet[256];
+	uint32 alphabetSize;
+	// index of each character in the alphabet, -1 if it is not in it
+	int charIndex[256];
+	// the successors of every state (a character index or START_STATE)
+	// in order of ascending level, as character indices and levels
+	unsigned char *successors;
+	unsigned char *levels;
+	// number of strings of a given length that may follow a state and
+	// whose levels sum up to a given level, see suffixCount
+	uint64 *suffixCounts;
+	// the tables above as the engine sees them
+	markovChain chain;
+};
+
+
+static inline uint64 suffixCount(const markovModel *m, uint32 length, uint32 state, uint32 level) {
+	return m->suffixCounts[((uint64)length * (m->alphabetSize + 1) + state) * (MAX_MARKOV_LEVEL + 1) + level];
+}
+
+static inline uint64 saturatingAdd(uint64 a, uint64 b) {
+	return (a + b < a) ? ~(uint64)0 : a + b;
+}
+
+/**
+ * Returns 2 * log2(total / count) rounded down, at most
+ * MAX_TRANSITION_LEVEL.
+ */
+static uint32 transitionLevel(uint64 count, uint64 total) {
+	double ratio = (double)total / count;
+	uint32 level = 0;
+	while (ratio >= SQRT2 && level < MAX_TRANSITION_LEVEL) {
+		ratio /= SQRT2;
+		level++;
+	}
+	return level;
+}
+
+static void computeSuffixCounts(markovModel *m) {
+	uint32 states = m->alphabetSize + 1;
+	uint32 length, s, level, k;
+
+	m->suffixCounts = (uint64*)calloc((uint64)(MAX_CANDIDATE_LENGTH + 1) * states * (MAX_MARKOV_LEVEL + 1),
+	                                  sizeof(uint64));
+	for (s = 0; s < states; s++) m->suffixCounts[(uint64)s * (MAX_MARKOV_LEVEL + 1)] = 1;
+
+	for (length = 1; length <= MAX_CANDIDATE_LENGTH; length++) {
+		for (s = 0; s < states; s++) {
+			uint64 *counts = &m->suffixCounts[((uint64)length * states + s) * (MAX_MARKOV_LEVEL + 1)];
+			const unsigned char *successors = &m->successors[s * m->alphabetSize];
+			const unsigned char *levels = &m->levels[s * m->alphabetSize];
+			for (level = 0; level <= MAX_MARKOV_LEVEL; level++) {
+				for (k = 0; k < m->alphabetSize && levels[k] <= level; k++) {
+					counts[level] = saturatingAdd(counts[level],
+					                              suffixCount(m, length - 1, successors[k], level - levels[k]));
+				}
+			}
+		}
+	}
+}
+
+
+markovModel *trainMarkovModel(char **words, uint32 wordCount, const char *alphabet, uint32 alphabetSize) {
+	markovModel *m;
+	uint32 states = alphabetSize + 1;
+	uint64 *counts;
+	uint32 i, s, k;
+
+	/* successors are stored as unsigned chars */
+	if (alphabetSize == 0 || alphabetSize > 256) return NULL;
+	m = (markovModel*)calloc(1, sizeof(markovModel));
+	counts = (uint64*)malloc((uint64)states * alphabetSize * sizeof(uint64));
+
+	memcpy(m->alphabet, alphabet, alphabetSize);
+	m->alphabetSize = alphabetSize;
+	for (i = 0; i < 256; i++) m->charIndex[i] = -1;
+	for (i = 0; i < alphabetSize; i++) m->charIndex[(unsigned char)alphabet[i]] = i;
+
+	for (i = 0; i < states * alphabetSize; i++) counts[i] = 1;
+	for (i = 0; i < wordCount; i++) {
+		const unsigned char *w = (const unsigned char*)words[i];
+		uint32 state = START_STATE(m);
+		for (; *w != 0 && m->charIndex[*w] >= 0; w++) {
+			counts[state * alphabetSize + m->charIndex[*w]]++;
+			state = m->charIndex[*w];
+		}
+	}
+
+	/* sort the successors of every state by level, stable in the alphabet */
+	m->successors = (unsigned char*)malloc(states * alphabetSize);
+	m->levels = (unsigned char*)malloc(states * alphabetSize);
+	for (s = 0; s < states; s++) {
+		unsigned char *successors = &m->successors[s * alphabetSize];
+		unsigned char *levels = &m->levels[s * alphabetSize];
+		uint64 total = 0;
+		for (i = 0; i < alphabetSize; i++) total += counts[s * alphabetSize + i];
+		for (i = 0; i < alphabetSize; i++) {
+			uint32 level = transitionLevel(counts[s * alphabetSize + i], total);
+			for (k = i; k > 0 && levels[k - 1] > level; k--) {
+				successors[k] = successors[k - 1];
+				levels[k] = levels[k - 1];
+			}
+			successors[k] = i;
+			levels[k] = level;
+		}
+	}
+	free(counts);
+
+	computeSuffixCounts(m);
+	m->chain.alphabet = m->alphabet;
+	m->chain.alphabetSize = alphabetSize;
+	m->chain.successors = m->successors;
+	m->chain.levels = m->levels;
+	m->chain.suffixCounts = m->suffixCounts;
+	return m;
+}
+
+void freeMarkovModel(markovModel *model) {
+	free(model->successors);
+	free(model->levels);
+	free(model->suffixCounts);
+	free(model);
+}
+
+
+uint64 markovLevelSize(const markovModel *model, uint32 length, uint32 level) {
+	if (length > MAX_CANDIDATE_LENGTH || level > MAX_MARKOV_LEVEL) return 0;
+	return suffixCount(model, length, START_STATE(model), level);
+}
+
+
+uint64 markovPosition(const markovModel *model, const char *password, uint32 maxLength, uint32 *level) {
+	uint32 length = strlen(password);
+	uint64 position = 0;
+	uint32 l, pos, k, state, remaining;
+
+	/* the level of password */
+	*level = 0;
+	state = START_STATE(model);
+	for (pos = 0; pos < length; pos++) {
+		int c = model->charIndex[(unsigned char)password[pos]];
+		if (c < 0) return ~(uint64)0;
+		for (k = 0; model->successors[state * model->alphabetSize + k] != c; k++);
+		*level += model->levels[state * model->alphabetSize + k];
+		state = c;
+	}
+	if (length == 0 || length > maxLength) return ~(uint64)0;
+
+	/* all candidates of lower levels, then the shorter ones of the same level */
+	for (l = 0; l < *level; l++) {
+		for (k = 1; k <= maxLength; k++) position = saturatingAdd(position, markovLevelSize(model, k, l));
+	}
+	for (k = 1; k < length; k++) position = saturatingAdd(position, markovLevelSize(model, k, *level));
+
+	/* the candidates of the same length and level before password */
+	state = START_STATE(model);
+	remaining = *level;
+	for (pos = 0; pos < length; pos++) {
+		const unsigned char *successors = &model->successors[state * model->alphabetSize];
+		const unsigned char *levels = &model->levels[state * model->alphabetSize];
+		int c = model->charIndex[(unsigned char)password[pos]];
+		for (k = 0; successors[k] != c; k++) {
+			if (levels[k] <= remaining) {
+				position = saturatingAdd(position, suffixCount(model, length - pos - 1, successors[k],
+				                                               remaining - levels[k]));
+			}
+		}
+		remaining -= levels[k];
+		state = c;
+	}
+	return position;
+}
+
+
+uint32 crackMarkov(const hashAlgorithm *alg, crackTarget *targets, uint32 targetCount,
+                   const markovModel *model, uint32 maxLength, uint32 maxLevel, uint32 threadCount) {
+	markovSlice *slices;
+	uint32 sliceCount = 0;
+	uint32 cracked = 0;
+	uint32 length, level, i;
+
+	if (maxLength > MAX_CANDIDATE_LENGTH) maxLength = MAX_CANDIDATE_LENGTH;
+	if (maxLevel > MAX_MARKOV_LEVEL) maxLevel = MAX_MARKOV_LEVEL;
+
+	/* level by level, and within a level by length, see markovPosition */
+	slices = (markovSlice*)malloc(((maxLevel + 1) * maxLength + 1) * sizeof(markovSlice));
+	for (level = 0; level <= maxLevel; level++) {
+		for (length = 1; length <= maxLength; length++) {
+			if (markovLevelSize(model, length, level) == 0) continue;
+			slices[sliceCount].chain = &model->chain;
+			slices[sliceCount].length = length;
+			slices[sliceCount].level = level;
+			sliceCount++;
+		}
+	}
+	crackSlices(alg, targets, targetCount, slices, sliceCount, threadCount);
+	free(slices);
+
+	for (i = 0; i < targetCount; i++) {
+		if (targets[i].cracked) cracked++;
+	}
+	return cracked;
+}
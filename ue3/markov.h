@@ -0,0 +1,53 @@
+#ifndef MARKOV_H
+#define MARKOV_H
+
+#include "crackEngine.h"
+
+
+
+/**
+ * A first-order Markov model of passwords over an alphabet. Every
+ * transition from one character (or the start of the password) to the
+ * next has a level that grows with its improbability, and the level of
+ * a candidate is the sum of the levels of its transitions. Candidates
+ * are enumerated level by level, i.e. roughly in descending
+ * probability, and within a level in a fixed order given by the
+ * numbers of candidates per suffix. So candidate i of a length and
+ * level can be computed without enumerating the ones before it, and
+ * the candidates can be split into ranges like the plain keyspace.
+ * The level constants and the tables the engine enumerates the
+ * candidates from are in crackEngine.h.
+**/
+typedef struct markovModel markovModel;
+
+/**
+ * Counts the transitions in the given words. Words are cut at the
+ * first character that is not in the alphabet. Every transition is
+ * counted once more than it occurs, so no candidate is impossible.
+ * Returns NULL if the alphabet is empty or has more than 256
+ * characters.
+**/
+extern markovModel *trainMarkovModel(char **words, uint32 wordCount, const char *alphabet, uint32 alphabetSize);
+extern void freeMarkovModel(markovModel *model);
+
+/**
+ * Returns the number of candidates with the given length and level,
+ * saturated at 2^64 - 1.
+**/
+extern uint64 markovLevelSize(const markovModel *model, uint32 length, uint32 level);
+/**
+ * Stores the level of password in level and returns the position of
+ * password in the order in which crackMarkov tries candidates of at
+ * most maxLength characters, counted from 0. Returns ~0 if password
+ * contains characters outside the alphabet.
+**/
+extern uint64 markovPosition(const markovModel *model, const char *password, uint32 maxLength, uint32 *level);
+/**
+ * Tries all candidates with at most maxLength characters up to level
+ * maxLevel in the order of the model, in a single run of the engine.
+ * Returns the number of cracked targets.
+**/
+extern uint32 crackMarkov(const hashAlgorithm *alg, crackTarget *targets, uint32 targetCount,
+                          const markovModel *model, uint32 maxLength, uint32 maxLevel, uint32 threadCount);
+
+#endif /* #ifndef MARKOV_H */
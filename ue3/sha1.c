@@ -42,87 +42,249 @@ bitBlock *pad(bitBlock *block) {
 	return result;
 }
 
-uint32 f1(uint32 b, uint32 c, uint32 d) {
-    return (b & c) | ((~b) & d);
+#define ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+/**
+ * Applies the sha-1 compression function for one 512-bit block
+ * to the five state words. The salted searches of the brute-force
+ * engine call this for every candidate, so the round functions are
+ * written out instead of being called through a table.
+**/
+void sha1Compress(uint32 *state, const uint32 *block) {
+	uint32 w[80];
+	uint32 a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+	uint32 t, z;
+
+	for (t = 0; t < 16; t++) w[t] = block[t];
+	for (t = 16; t < 80; t++) w[t] = ROTL(w[t - 3] ^ w[t - 8] ^ w[t - 14] ^ w[t - 16], 1);
+
+	for (t = 0; t < 80; t++) {
+		if (t < 20) z = ((b & c) | (~b & d)) + 0x5A827999;
+		else if (t < 40) z = (b ^ c ^ d) + 0x6ED9EBA1;
+		else if (t < 60) z = ((b & c) | (b & d) | (c & d)) + 0x8F1BBCDC;
+		else z = (b ^ c ^ d) + 0xCA62C1D6;
+		z += ROTL(a, 5) + e + w[t];
+		e = d;
+		d = c;
+		c = ROTL(b, 30);
+		b = a;
+		a = z;
+	}
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
 }
 
-uint32 f2(uint32 b, uint32 c, uint32 d) {
-    return b ^ c ^ d;
+
+uint32 *sha1(bitBlock *message) {
+	uint32* result = (uint32*)calloc(5, sizeof(uint32));
+    uint32 globalWordCounter;
+
+	result[0] = 0x67452301;
+	result[1] = 0xEFCDAB89;
+	result[2] = 0x98BADCFE;
+	result[3] = 0x10325476;
+	result[4] = 0xC3D2E1F0;
+
+    message = pad(message);
+    for (globalWordCounter = 0; globalWordCounter < message->wordCount; globalWordCounter += 16) {
+        sha1Compress(result, &message->data[globalWordCounter]);
+    }
+    freeBitBlock(message);
+	return result;
 }
 
-uint32 f3(uint32 b, uint32 c, uint32 d) {
-    return (b & c) | (b & d) | (c & d);
+
+void sha1Init(sha1Context *ctx) {
+	uint32 i;
+	ctx->state[0] = 0x67452301;
+	ctx->state[1] = 0xEFCDAB89;
+	ctx->state[2] = 0x98BADCFE;
+	ctx->state[3] = 0x10325476;
+	ctx->state[4] = 0xC3D2E1F0;
+	for (i = 0; i < 16; i++) ctx->block[i] = 0;
+	ctx->blockBytes = 0;
+	ctx->length = 0;
 }
 
 
+void sha1Update(sha1Context *ctx, const unsigned char *data, uint32 count) {
+	uint32 i = 0;
+	uint32 j;
+	ctx->length += count;
+
+	/* fill up a partial block byte by byte */
+	while (i < count && ctx->blockBytes != 0) {
+		ctx->block[ctx->blockBytes / 4] |= (uint32)data[i] << ((3 - (ctx->blockBytes % 4)) * 8);
+		ctx->blockBytes++;
+		i++;
+		if (ctx->blockBytes == 64) {
+			sha1Compress(ctx->state, ctx->block);
+			for (j = 0; j < 16; j++) ctx->block[j] = 0;
+			ctx->blockBytes = 0;
+		}
+	}
+
+	/* whole blocks are converted to big-endian words directly */
+	while (count - i >= 64) {
+		uint32 w[16];
+		for (j = 0; j < 16; j++, i += 4) {
+			w[j] = ((uint32)data[i] << 24) | ((uint32)data[i + 1] << 16) |
+			       ((uint32)data[i + 2] << 8) | (uint32)data[i + 3];
+		}
+		sha1Compress(ctx->state, w);
+	}
 
-uint32 *sha1(bitBlock *message) {
-	uint32* result = (uint32*)calloc(5, sizeof(uint32));
-	uint32 a0 = 0x67452301;
-	uint32 b0 = 0xEFCDAB89;
-	uint32 c0 = 0x98BADCFE;
-	uint32 d0 = 0x10325476;
-	uint32 e0 = 0xC3D2E1F0;
-	uint32 a1, b1, c1, d1, e1;
-    uint32 rot5HighMask = 0b11111 << 27;
-	uint32 rot5LowMask = ~rot5HighMask;
-    uint32 k[4] = {0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6};
-    uint32 (*f[4])(uint32, uint32, uint32) = {f1, f2, f3, f2};
-	uint32 msf[16];
-	uint32 roundCounter;
-    uint32 globalWordCounter = 0;
-    uint32 i;    
-    uint32 z;
+	while (i < count) {
+		ctx->block[ctx->blockBytes / 4] |= (uint32)data[i] << ((3 - (ctx->blockBytes % 4)) * 8);
+		ctx->blockBytes++;
+		i++;
+	}
+}
 
-    message = pad(message);
 
+void sha1Final(sha1Context *ctx, uint32 *hash) {
+	uint64 bits = ctx->length * 8;
+	uint32 i;
 
-    while (globalWordCounter < message->wordCount) {
-        a1 = a0;
-        b1 = b0;
-        c1 = c0;
-        d1 = d0;
-        e1 = e0;
-
-        for (i = 0; i < 16; i++, globalWordCounter++) {
-            msf[i] = message->data[globalWordCounter];
-        }
-
-        for (roundCounter = 0; roundCounter < 80; roundCounter++) {
-            uint32 stage = roundCounter / 20;
-            if (roundCounter >= 16) {
-                z = msf[(roundCounter - 16) % 16] ^
-                    msf[(roundCounter - 14) % 16] ^
-                    msf[(roundCounter - 8) % 16] ^
-                    msf[(roundCounter - 3) % 16];
-                msf[roundCounter % 16] = (z << 1) | ((z & 0x80000000) >> 31);
-            }
-
-            z = e1 +
-                f[stage](b1, c1, d1) +
-                (((a1 & rot5HighMask) >> 27) + (a1 << 5)) +
-                msf[roundCounter % 16] +
-                k[stage];
-            e1 = d1;
-            d1 = c1;
-            c1 = ((b1 & 3) << 30) + (b1 >> 2);
-            b1 = a1;
-            a1 = z;
-        }
-        a0 = a0 + a1;
-        b0 = b0 + b1;
-        c0 = c0 + c1;
-        d0 = d0 + d1;
-        e0 = e0 + e1;
-    }
+	ctx->block[ctx->blockBytes / 4] |= 0x80U << ((3 - (ctx->blockBytes % 4)) * 8);
+	if (ctx->blockBytes >= 56) {
+		sha1Compress(ctx->state, ctx->block);
+		for (i = 0; i < 16; i++) ctx->block[i] = 0;
+	}
+	ctx->block[14] = (uint32)(bits >> 32);
+	ctx->block[15] = (uint32)bits;
+	sha1Compress(ctx->state, ctx->block);
 
-    result[0] = a0;
-    result[1] = b0;
-    result[2] = c0;
-    result[3] = d0;
-    result[4] = e0;
-    freeBitBlock(message);
-	return result;
+	for (i = 0; i < 5; i++) hash[i] = ctx->state[i];
+}
+
+
+void hmacSha1Init(hmacKey *k, const unsigned char *key, uint32 keyLength) {
+	uint32 block[16];
+	uint32 keyHash[5];
+	uint32 i;
+	sha1Context ctx;
+
+	for (i = 0; i < 16; i++) block[i] = 0;
+	if (keyLength > 64) {
+		sha1Init(&ctx);
+		sha1Update(&ctx, key, keyLength);
+		sha1Final(&ctx, keyHash);
+		for (i = 0; i < 5; i++) block[i] = keyHash[i];
+	} else {
+		for (i = 0; i < keyLength; i++) {
+			block[i / 4] |= (uint32)key[i] << ((3 - (i % 4)) * 8);
+		}
+	}
+
+	sha1Init(&ctx);
+	for (i = 0; i < 16; i++) block[i] ^= 0x36363636;
+	sha1Compress(ctx.state, block);
+	for (i = 0; i < 5; i++) k->inner[i] = ctx.state[i];
+
+	sha1Init(&ctx);
+	for (i = 0; i < 16; i++) block[i] ^= 0x36363636 ^ 0x5c5c5c5c;
+	sha1Compress(ctx.state, block);
+	for (i = 0; i < 5; i++) k->outer[i] = ctx.state[i];
+}
+
+/**
+ * Continues a sha-1 computation from the given midstate, which already
+ * covers one 64-byte block.
+ */
+static void sha1FromMidstate(sha1Context *ctx, const uint32 *midstate) {
+	uint32 i;
+	sha1Init(ctx);
+	for (i = 0; i < 5; i++) ctx->state[i] = midstate[i];
+	ctx->length = 64;
+}
+
+/**
+ * Finishes an HMAC whose inner hash has been fed the message.
+ */
+static void hmacSha1Final(const hmacKey *k, sha1Context *inner, uint32 *mac) {
+	sha1Context ctx;
+	unsigned char innerHash[20];
+	uint32 i;
+
+	sha1Final(inner, mac);
+	for (i = 0; i < 20; i++) innerHash[i] = mac[i / 4] >> ((3 - (i % 4)) * 8);
+	sha1FromMidstate(&ctx, k->outer);
+	sha1Update(&ctx, innerHash, 20);
+	sha1Final(&ctx, mac);
+}
+
+void hmacSha1(const hmacKey *k, const unsigned char *msg, uint32 length, uint32 *mac) {
+	sha1Context ctx;
+	sha1FromMidstate(&ctx, k->inner);
+	sha1Update(&ctx, msg, length);
+	hmacSha1Final(k, &ctx, mac);
+}
+
+/**
+ * After the first iteration every message is a 20-byte hash, so the
+ * padded block is built once and each iteration only runs two
+ * compressions from the precomputed midstates.
+ */
+void pbkdf2Sha1(const unsigned char *password, uint32 passwordLength,
+                const unsigned char *salt, uint32 saltLength,
+                uint32 iterations, uint32 *result) {
+	const unsigned char blockIndex[4] = {0, 0, 0, 1};
+	hmacKey k;
+	sha1Context ctx;
+	uint32 block[16];
+	uint32 u[5];
+	uint32 i, j;
+
+	hmacSha1Init(&k, password, passwordLength);
+
+	/* U1 = HMAC(password, salt || INT(1)) */
+	sha1FromMidstate(&ctx, k.inner);
+	sha1Update(&ctx, salt, saltLength);
+	sha1Update(&ctx, blockIndex, 4);
+	hmacSha1Final(&k, &ctx, u);
+	for (j = 0; j < 5; j++) result[j] = u[j];
+
+	/* 20 message bytes after one 64-byte key block, padded */
+	for (j = 0; j < 16; j++) block[j] = 0;
+	block[5] = 0x80000000;
+	block[15] = (64 + 20) * 8;
+
+	for (i = 1; i < iterations; i++) {
+		for (j = 0; j < 5; j++) {
+			block[j] = u[j];
+			u[j] = k.inner[j];
+		}
+		sha1Compress(u, block);
+		for (j = 0; j < 5; j++) {
+			block[j] = u[j];
+			u[j] = k.outer[j];
+		}
+		sha1Compress(u, block);
+		for (j = 0; j < 5; j++) result[j] ^= u[j];
+	}
+}
+
+
+boolean parseHexDigest(const char *hex, uint32 wordCount, boolean bigEndian, uint32 *digest) {
+	uint32 i, j;
+	for (i = 0; i < wordCount; i++) digest[i] = 0;
+	for (i = 0; i < 4 * wordCount; i++) {
+		uint32 byte = 0;
+		for (j = 0; j < 2; j++) {
+			char c = hex[2 * i + j];
+			byte <<= 4;
+			if (c >= '0' && c <= '9') byte |= c - '0';
+			else if (c >= 'a' && c <= 'f') byte |= c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F') byte |= c - 'A' + 10;
+			else return FALSE;
+		}
+		digest[i / 4] |= byte << (bigEndian ? (3 - (i % 4)) * 8 : (i % 4) * 8);
+	}
+	return TRUE;
 }
 
 
@@ -190,4 +352,4 @@ void test() {
     printWordArrayHex(hash, 5);
     free(hash);
     freeBitBlock(msg);
-}
\ No newline at end of file
+}
@@ -8,6 +8,7 @@ typedef unsigned int uint16;
 typedef signed int sint16;
 typedef unsigned int uint8;
 typedef signed int sint8;
+typedef unsigned long long uint64;
 
 typedef uint8 boolean;
 #define FALSE (uint8)0
@@ -23,6 +24,29 @@ typedef struct {
 } bitBlock;
 
 
+/**
+ * State of an incremental sha-1 computation. block collects the
+ * bytes of the current 512-bit block in big-endian words, blockBytes
+ * is the number of bytes in it and length the number of bytes
+ * hashed so far.
+**/
+typedef struct {
+	uint32 state[5];
+	uint32 block[16];
+	uint32 blockBytes;
+	uint64 length;
+} sha1Context;
+
+/**
+ * The two HMAC-SHA1 midstates of a key: the state after compressing
+ * key ^ ipad and the state after compressing key ^ opad.
+**/
+typedef struct {
+	uint32 inner[5];
+	uint32 outer[5];
+} hmacKey;
+
+
 /**
  * Reserves memory for a new bitBlock. 
  * The number of data-Elements is given by wordCount.
@@ -65,5 +89,47 @@ extern void printWordArrayBits(uint32 *a, uint32 size);
  * of the returned array is always 5 (since 5 * 32 Bits  = 160 Bits).
 **/
 extern uint32 *sha1(bitBlock *message);
+/**
+ * Applies the sha-1 compression function for the 16 words of block
+ * to the 5 words of state.
+**/
+extern void sha1Compress(uint32 *state, const uint32 *block);
+/**
+ * Prepares ctx for hashing a new message piece by piece. Unlike sha1,
+ * this works on byte streams of arbitrary length and never needs the
+ * whole message in memory.
+**/
+extern void sha1Init(sha1Context *ctx);
+/**
+ * Hashes the next count bytes of the message.
+**/
+extern void sha1Update(sha1Context *ctx, const unsigned char *data, uint32 count);
+/**
+ * Pads the message and stores the 5 words of its hash in hash.
+**/
+extern void sha1Final(sha1Context *ctx, uint32 *hash);
+/**
+ * Computes the HMAC midstates for the given key, which costs two
+ * compressions (three if the key is longer than a block).
+**/
+extern void hmacSha1Init(hmacKey *k, const unsigned char *key, uint32 keyLength);
+/**
+ * Computes HMAC-SHA1 of an arbitrary message.
+**/
+extern void hmacSha1(const hmacKey *k, const unsigned char *msg, uint32 length, uint32 *mac);
+/**
+ * Computes the first 20 bytes of PBKDF2-HMAC-SHA1.
+**/
+extern void pbkdf2Sha1(const unsigned char *password, uint32 passwordLength,
+                       const unsigned char *salt, uint32 saltLength,
+                       uint32 iterations, uint32 *result);
+/**
+ * Parses the usual hexadecimal representation of a digest of
+ * wordCount words, i.e. its bytes in order. bigEndian tells whether
+ * the words are filled from their most significant byte (sha family)
+ * or from their least significant one (md4, md5). Returns FALSE if
+ * hex does not start with 8 * wordCount hexadecimal digits.
+**/
+extern boolean parseHexDigest(const char *hex, uint32 wordCount, boolean bigEndian, uint32 *digest);
 
-#endif /* #ifndef SHA1_H */
\ No newline at end of file
+#endif /* #ifndef SHA1_H */
@@ -0,0 +1,335 @@
+#define _GNU_SOURCE
+#include "sha1.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <aio.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <pthread.h>
+
+/*
+ * Computes or verifies the sha-1 hashes of many files in parallel.
+ *
+ *   sha1sum [-j threads] path...     hashes all files, directories
+ *                                    are walked recursively
+ *   sha1sum [-j threads] -c list     verifies the hashes in list
+ *
+ * The output format is that of coreutils' sha1sum. Build with
+ *   gcc -O2 -pthread sha1sum.c sha1.c -o sha1sum
+ */
+
+/* size of each of the two read buffers per file */
+#define CHUNK_SIZE (1U << 20)
+#define MAX_THREADS 256
+#define HEX_DIGITS 40
+
+
+typedef struct {
+	char *path;
+	uint32 hash[5];
+	uint32 expected[5];
+	// TRUE if the job comes from a checksum list
+	boolean verify;
+	// 0 on success, otherwise the errno of the failed operation
+	int error;
+	boolean done;
+} hashJob;
+
+typedef struct {
+	hashJob *jobs;
+	// number of jobs that can be stored in the jobs array
+	uint32 capacity;
+	// number of jobs that really are stored in the jobs array
+	uint32 jobCount;
+	// index of the next job a worker takes
+	uint32 nextJob;
+	// index of the next job whose result is printed
+	uint32 nextOutput;
+	// everything that makes the exit status non-zero
+	uint32 failures;
+	// what -c reports separately, like coreutils does
+	uint32 malformedLines;
+	uint32 unreadable;
+	uint32 mismatches;
+	pthread_mutex_t outputLock;
+} jobQueue;
+
+
+static jobQueue queue;
+
+
+/**
+ * Appends a job for the given path, which is copied.
+ */
+void addJob(const char *path) {
+	if (queue.jobCount >= queue.capacity) {
+		hashJob *newJobs;
+		queue.capacity = (queue.capacity == 0) ? 64 : queue.capacity * 2;
+		newJobs = (hashJob*)realloc(queue.jobs, queue.capacity * sizeof(hashJob));
+		if (newJobs == NULL) {
+			fprintf(stderr, "Could not grow the job queue.\n");
+			exit(1);
+		}
+		queue.jobs = newJobs;
+	}
+	memset(&queue.jobs[queue.jobCount], 0, sizeof(hashJob));
+	queue.jobs[queue.jobCount].path = strdup(path);
+	queue.jobCount++;
+}
+
+int collectFile(const char *path, const struct stat *sb, int type, struct FTW *ftwbuf) {
+	(void)sb;
+	(void)ftwbuf;
+	if (type == FTW_F) addJob(path);
+	return 0;
+}
+
+/**
+ * Adds a job for every regular file below path. path itself may
+ * also be a file. Symbolic links are not followed below path, unless
+ * path itself is a link to a directory.
+ */
+void collectFiles(const char *path) {
+	struct stat sb;
+	int flags = FTW_PHYS;
+	if (stat(path, &sb) == 0 && !S_ISDIR(sb.st_mode)) {
+		addJob(path);
+		return;
+	}
+	/* a link to a directory is only walked if links are followed */
+	if (lstat(path, &sb) == 0 && S_ISLNK(sb.st_mode)) flags = 0;
+	if (nftw(path, collectFile, 64, flags) != 0) {
+		fprintf(stderr, "sha1sum: %s: %s\n", path, strerror(errno));
+		queue.failures++;
+	}
+}
+
+/**
+ * Adds a verification job for every line of the given checksum list.
+ * Lines have the form "<hash>  <path>" or "<hash> *<path>".
+ */
+void loadChecksumList(const char *fileName) {
+	FILE *f = fopen(fileName, "r");
+	char *line = NULL;
+	size_t lineCapacity = 0;
+	ssize_t length;
+
+	if (f == NULL) {
+		fprintf(stderr, "sha1sum: %s: %s\n", fileName, strerror(errno));
+		exit(1);
+	}
+	while ((length = getline(&line, &lineCapacity, f)) != -1) {
+		uint32 hash[5];
+		while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+			line[--length] = 0;
+		}
+		if (length < HEX_DIGITS + 3 || !parseHexDigest(line, 5, TRUE, hash) || line[HEX_DIGITS] != ' ' ||
+		    (line[HEX_DIGITS + 1] != ' ' && line[HEX_DIGITS + 1] != '*')) {
+			if (length > 0) {
+				fprintf(stderr, "sha1sum: %s: improperly formatted line\n", fileName);
+				queue.malformedLines++;
+			}
+			continue;
+		}
+		addJob(&line[HEX_DIGITS + 2]);
+		memcpy(queue.jobs[queue.jobCount - 1].expected, hash, sizeof(hash));
+		queue.jobs[queue.jobCount - 1].verify = TRUE;
+	}
+	free(line);
+	fclose(f);
+}
+
+
+/**
+ * Waits for the given read request and returns its result. The error
+ * state is stored in error before aio_return releases the request,
+ * after which aio_error must not be called on it any more.
+ */
+ssize_t finishRead(struct aiocb *cb, int *error) {
+	const struct aiocb *list[1] = {cb};
+	while ((*error = aio_error(cb)) == EINPROGRESS) {
+		aio_suspend(list, 1, NULL);
+	}
+	return aio_return(cb);
+}
+
+/**
+ * Hashes the file at path into hash. The file is read with two
+ * buffers: while one chunk is hashed, the next one is already being
+ * read asynchronously. Returns 0 or an errno value.
+ */
+int hashFile(const char *path, uint32 *hash) {
+	unsigned char *buffers[2];
+	struct aiocb cb;
+	sha1Context ctx;
+	off_t offset = 0;
+	uint32 current = 0;
+	ssize_t count;
+	int error = 0;
+	int readError;
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0) return errno;
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	buffers[0] = (unsigned char*)malloc(CHUNK_SIZE);
+	buffers[1] = (unsigned char*)malloc(CHUNK_SIZE);
+	sha1Init(&ctx);
+
+	memset(&cb, 0, sizeof(cb));
+	cb.aio_fildes = fd;
+	cb.aio_nbytes = CHUNK_SIZE;
+	cb.aio_buf = buffers[current];
+	cb.aio_offset = offset;
+	if (aio_read(&cb) != 0) error = errno;
+
+	while (error == 0) {
+		count = finishRead(&cb, &readError);
+		if (count < 0) {
+			error = readError;
+			break;
+		}
+		if (count == 0) break;
+		offset += count;
+
+		cb.aio_buf = buffers[1 - current];
+		cb.aio_offset = offset;
+		if (aio_read(&cb) != 0) error = errno;
+
+		sha1Update(&ctx, buffers[current], (uint32)count);
+		current = 1 - current;
+	}
+	/* on every way out of the loop no read is pending: either it has
+	 * been finished or aio_read failed to queue it */
+
+	sha1Final(&ctx, hash);
+	free(buffers[0]);
+	free(buffers[1]);
+	close(fd);
+	return error;
+}
+
+
+boolean hashesEqual(uint32 *h1, uint32 *h2) {
+	uint32 i;
+	for (i = 0; i < 5; i++) {
+		if (h1[i] != h2[i]) return FALSE;
+	}
+	return TRUE;
+}
+
+void printResult(hashJob *job) {
+	if (job->error != 0) {
+		fprintf(stderr, "sha1sum: %s: %s\n", job->path, strerror(job->error));
+		if (job->verify) queue.unreadable++;
+		queue.failures++;
+	} else if (job->verify) {
+		boolean ok = hashesEqual(job->hash, job->expected);
+		printf("%s: %s\n", job->path, ok ? "OK" : "FAILED");
+		if (!ok) {
+			queue.mismatches++;
+			queue.failures++;
+		}
+	} else {
+		uint32 i;
+		for (i = 0; i < 5; i++) printf("%08x", job->hash[i]);
+		printf("  %s\n", job->path);
+	}
+}
+
+/**
+ * Takes jobs from the queue until it is empty. Results are printed in
+ * queue order as soon as all earlier jobs are done.
+ */
+void *worker(void *arg) {
+	(void)arg;
+	while (1<2) {
+		uint32 index = __atomic_fetch_add(&queue.nextJob, 1, __ATOMIC_RELAXED);
+		if (index >= queue.jobCount) break;
+		hashJob *job = &queue.jobs[index];
+		job->error = hashFile(job->path, job->hash);
+
+		pthread_mutex_lock(&queue.outputLock);
+		job->done = TRUE;
+		while (queue.nextOutput < queue.jobCount && queue.jobs[queue.nextOutput].done) {
+			printResult(&queue.jobs[queue.nextOutput]);
+			queue.nextOutput++;
+		}
+		pthread_mutex_unlock(&queue.outputLock);
+	}
+	return NULL;
+}
+
+
+void usage(void) {
+	fprintf(stderr, "usage: sha1sum [-j threads] path...\n");
+	fprintf(stderr, "       sha1sum [-j threads] -c list\n");
+	exit(1);
+}
+
+int main(int argc, char **argv) {
+	pthread_t threads[MAX_THREADS];
+	struct aioinit init;
+	long threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+	char *checksumList = NULL;
+	int i;
+
+	pthread_mutex_init(&queue.outputLock, NULL);
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			threadCount = atol(argv[++i]);
+		} else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+			checksumList = argv[++i];
+		} else if (argv[i][0] == '-') {
+			usage();
+		} else {
+			collectFiles(argv[i]);
+		}
+	}
+	if (checksumList != NULL) {
+		loadChecksumList(checksumList);
+		if (queue.jobCount == 0) {
+			fprintf(stderr, "sha1sum: %s: no properly formatted SHA1 checksum lines found\n", checksumList);
+			return 1;
+		}
+	}
+	if (queue.jobCount == 0 && queue.failures == 0) usage();
+	if (threadCount < 1) threadCount = 1;
+	if (threadCount > MAX_THREADS) threadCount = MAX_THREADS;
+	if (threadCount > (long)queue.jobCount) threadCount = queue.jobCount;
+
+	/* one outstanding read per worker thread */
+	memset(&init, 0, sizeof(init));
+	init.aio_threads = threadCount;
+	init.aio_num = threadCount;
+	init.aio_idle_time = 1;
+	aio_init(&init);
+
+	for (i = 0; i < threadCount; i++) {
+		pthread_create(&threads[i], NULL, worker, NULL);
+	}
+	for (i = 0; i < threadCount; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	if (checksumList != NULL) {
+		if (queue.malformedLines > 0) {
+			fprintf(stderr, "sha1sum: WARNING: %u line%s improperly formatted\n",
+			        queue.malformedLines, queue.malformedLines == 1 ? " is" : "s are");
+		}
+		if (queue.unreadable > 0) {
+			fprintf(stderr, "sha1sum: WARNING: %u listed file%s could not be read\n",
+			        queue.unreadable, queue.unreadable == 1 ? "" : "s");
+		}
+		if (queue.mismatches > 0) {
+			fprintf(stderr, "sha1sum: WARNING: %u computed checksum%s did NOT match\n",
+			        queue.mismatches, queue.mismatches == 1 ? "" : "s");
+		}
+	}
+	for (i = 0; i < (int)queue.jobCount; i++) free(queue.jobs[i].path);
+	free(queue.jobs);
+	return queue.failures > 0;
+}
@@ -0,0 +1,330 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Order, cycle and discrete-log queries for sequences z <- z * g mod n
+ * like the one printed by ue4.c. All moduli have to be below 2^32, so
+ * every product of two residues fits into 64 bits.
+ */
+
+typedef unsigned int uint32;
+typedef unsigned long long uint64;
+
+typedef uint32 boolean;
+#define FALSE (uint32)0
+#define TRUE (uint32)1
+
+/* a number below 2^32 has at most 9 distinct prime factors */
+#define MAX_FACTORS 16
+#define HASH_EMPTY 0xFFFFFFFFU
+
+
+typedef struct {
+	uint32 primes[MAX_FACTORS];
+	uint32 exponents[MAX_FACTORS];
+	uint32 count;
+} factorization;
+
+
+/**
+ * Open-addressing hash table from residues to exponents, used for the
+ * baby steps. Keys and values are stored in one array of pairs so a
+ * probe touches a single cache line. HASH_EMPTY marks a free slot,
+ * which is never a valid residue.
+ */
+typedef struct {
+	uint32 *slots;
+	uint32 mask;
+} hashTable;
+
+
+uint64 mulMod(uint64 a, uint64 b, uint64 n) {
+	return a * b % n;
+}
+
+uint64 powMod(uint64 a, uint64 e, uint64 n) {
+	uint64 r = 1 % n;
+	a %= n;
+	while (e > 0) {
+		if (e & 1) r = mulMod(r, a, n);
+		a = mulMod(a, a, n);
+		e >>= 1;
+	}
+	return r;
+}
+
+/**
+ * Returns the integer square root of a, i.e. floor(sqrt(a)), by
+ * Newton's method.
+ */
+uint64 isqrt(uint64 a) {
+	uint64 x, y;
+	if (a < 2) return a;
+	x = a / 2 + 1;
+	y = (x + a / x) / 2;
+	while (y < x) {
+		x = y;
+		y = (x + a / x) / 2;
+	}
+	return x;
+}
+
+uint64 gcd(uint64 a, uint64 b) {
+	while (b != 0) {
+		uint64 h = a % b;
+		a = b;
+		b = h;
+	}
+	return a;
+}
+
+/**
+ * Factorizes n by trial division. Since n < 2^32, no divisor above
+ * 2^16 has to be tried.
+ */
+factorization factorize(uint64 n) {
+	factorization f;
+	uint64 p;
+	f.count = 0;
+	for (p = 2; p * p <= n; p += (p == 2) ? 1 : 2) {
+		if (n % p != 0) continue;
+		f.primes[f.count] = p;
+		f.exponents[f.count] = 0;
+		while (n % p == 0) {
+			n /= p;
+			f.exponents[f.count]++;
+		}
+		f.count++;
+	}
+	if (n > 1) {
+		f.primes[f.count] = n;
+		f.exponents[f.count] = 1;
+		f.count++;
+	}
+	return f;
+}
+
+/**
+ * Returns Euler's phi of n.
+ */
+uint64 phi(uint64 n) {
+	factorization f = factorize(n);
+	uint64 result = n;
+	uint32 i;
+	for (i = 0; i < f.count; i++) {
+		result = result / f.primes[i] * (f.primes[i] - 1);
+	}
+	return result;
+}
+
+/**
+ * Returns the multiplicative order of g modulo n, i.e. the period of
+ * z <- z * g mod n started at z = 1. Starting from phi(n), every prime
+ * factor is removed as long as g^(order / p) is still 1. Returns 0 if
+ * g is not invertible modulo n.
+ */
+uint64 multiplicativeOrder(uint64 g, uint64 n) {
+	uint64 order;
+	factorization f;
+	uint32 i, j;
+
+	if (gcd(g % n, n) != 1) return 0;
+	order = phi(n);
+	f = factorize(order);
+	for (i = 0; i < f.count; i++) {
+		for (j = 0; j < f.exponents[i]; j++) {
+			if (powMod(g, order / f.primes[i], n) != 1) break;
+			order /= f.primes[i];
+		}
+	}
+	return order;
+}
+
+
+/**
+ * An arbitrary step function on residues for cycle detection.
+ */
+typedef uint64 (*stepFunction)(uint64 z, const void *context);
+
+/**
+ * Detects the cycle of the sequence z, f(z), f(f(z)), ... with Brent's
+ * algorithm. Stores the length of the cycle in lambda and the index
+ * of its first element in mu. Needs O(mu + lambda) steps and constant
+ * memory.
+ */
+void brentCycle(stepFunction f, const void *context, uint64 z0, uint64 *lambda, uint64 *mu) {
+	uint64 power = 1;
+	uint64 length = 1;
+	uint64 tortoise = z0;
+	uint64 hare = f(z0, context);
+	uint64 i;
+
+	/* search successive powers of two for the cycle length */
+	while (tortoise != hare) {
+		if (power == length) {
+			tortoise = hare;
+			power *= 2;
+			length = 0;
+		}
+		hare = f(hare, context);
+		length++;
+	}
+	*lambda = length;
+
+	/* a hare lambda steps ahead meets the tortoise at the cycle start */
+	tortoise = z0;
+	hare = z0;
+	for (i = 0; i < length; i++) hare = f(hare, context);
+	*mu = 0;
+	while (tortoise != hare) {
+		tortoise = f(tortoise, context);
+		hare = f(hare, context);
+		(*mu)++;
+	}
+}
+
+
+/**
+ * Reserves a table that can hold at least capacity entries at a load
+ * factor of at most 1/2.
+ */
+hashTable *initHashTable(uint32 capacity) {
+	hashTable *t = (hashTable*)calloc(1, sizeof(hashTable));
+	uint64 size = 2;
+	uint64 i;
+	while (size < 2 * (uint64)capacity) size *= 2;
+	t->mask = size - 1;
+	t->slots = (uint32*)malloc(2 * size * sizeof(uint32));
+	for (i = 0; i < size; i++) t->slots[2 * i] = HASH_EMPTY;
+	return t;
+}
+
+void freeHashTable(hashTable *t) {
+	free(t->slots);
+	free(t);
+}
+
+uint32 hashSlot(const hashTable *t, uint32 key) {
+	return (uint32)((key * 0x9E3779B97F4A7C15ULL) >> 32) & t->mask;
+}
+
+/**
+ * Inserts key with the given value. Keys that are already present keep
+ * their first value.
+ */
+void hashInsert(hashTable *t, uint32 key, uint32 value) {
+	uint32 i = hashSlot(t, key);
+	while (t->slots[2 * i] != HASH_EMPTY) {
+		if (t->slots[2 * i] == key) return;
+		i = (i + 1) & t->mask;
+	}
+	t->slots[2 * i] = key;
+	t->slots[2 * i + 1] = value;
+}
+
+/**
+ * Returns TRUE and stores the value in value if key is present.
+ */
+boolean hashLookup(const hashTable *t, uint32 key, uint32 *value) {
+	uint32 i = hashSlot(t, key);
+	while (t->slots[2 * i] != HASH_EMPTY) {
+		if (t->slots[2 * i] == key) {
+			*value = t->slots[2 * i + 1];
+			return TRUE;
+		}
+		i = (i + 1) & t->mask;
+	}
+	return FALSE;
+}
+
+/**
+ * Solves g^x = h mod n with baby-step giant-step, where order has to
+ * be the multiplicative order of g. Needs O(sqrt(order)) time and
+ * memory. Returns TRUE and stores the smallest solution in x if h is
+ * a power of g, otherwise FALSE. Also returns FALSE if order is 0,
+ * i.e. g is not invertible and has no inverse giant step.
+ */
+boolean discreteLog(uint64 g, uint64 h, uint64 n, uint64 order, uint64 *x) {
+	uint64 m;
+	uint64 z = 1 % n;
+	uint64 giantStep, i;
+	uint32 j;
+	hashTable *t;
+
+	if (order == 0) return FALSE;
+	g %= n;
+	/* the smallest m with m * m >= order */
+	m = isqrt(order);
+	if (m * m < order) m++;
+	t = initHashTable(m);
+
+	/* baby steps: g^j for j < m */
+	for (j = 0; j < m; j++) {
+		hashInsert(t, z, j);
+		z = mulMod(z, g, n);
+	}
+
+	/* giant steps: h * g^(-m*i), with g^(-m) = g^(order - m) */
+	giantStep = powMod(g, (order - m % order) % order, n);
+	z = h % n;
+	for (i = 0; i < m; i++) {
+		if (hashLookup(t, z, &j)) {
+			*x = i * m + j;
+			freeHashTable(t);
+			return TRUE;
+		}
+		z = mulMod(z, giantStep, n);
+	}
+	freeHashTable(t);
+	return FALSE;
+}
+
+
+typedef struct {
+	uint64 g;
+	uint64 n;
+} multiplyStep;
+
+uint64 multiplyByG(uint64 z, const void *context) {
+	const multiplyStep *s = (const multiplyStep*)context;
+	return mulMod(z, s->g, s->n);
+}
+
+/**
+ * Answers the period and discrete-log questions for the sequence
+ * z <- z * g mod n that starts at 1.
+ */
+void analyze(uint64 g, uint64 n, uint64 term) {
+	multiplyStep step = {g, n};
+	uint64 order = multiplicativeOrder(g, n);
+	uint64 z = powMod(g, term, n);
+	uint64 lambda, mu, x;
+
+	printf("z <- z * %llu mod %llu\n", g, n);
+	if (order == 0) {
+		printf("  %llu is not invertible mod %llu, so the sequence is not purely periodic\n", g, n);
+	} else {
+		printf("  order of %llu: %llu\n", g, order);
+	}
+	if (n <= 100000 || order == 0) {
+		brentCycle(multiplyByG, &step, 1, &lambda, &mu);
+		printf("  brent: cycle length %llu, starts at index %llu\n", lambda, mu);
+	}
+	if (discreteLog(g, z, n, order, &x)) {
+		printf("  term %llu is %llu, which first appears at index %llu\n", term, z, x);
+	} else if (order == 0) {
+		/* without an inverse there are no giant steps, but the first
+		 * occurrence follows from the tail and the cycle */
+		x = (term < mu) ? term : mu + (term - mu) % lambda;
+		printf("  term %llu is %llu, which first appears at index %llu\n", term, z, x);
+	}
+}
+
+
+int main() {
+	analyze(7, 437, 98);
+	analyze(19, 437, 5);
+	analyze(2, 4294967291ULL, 3000000000ULL);
+	analyze(3, 4294967029ULL, 123456789ULL);
+	return 0;
+}
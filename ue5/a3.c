@@ -3,59 +3,188 @@
 #include <stdlib.h>
 
 
+// Registry of named functions. All memory is reserved statically:
+// every entry holds its name inline and is found through an
+// open-addressing index with linear probing, so registering,
+// renaming and looking up never allocate and never write past a
+// buffer, no matter what the input is.
+
+#define MAX_FUNCTIONS 4096
+#define MAX_NAME_LENGTH 31
+// power of two and at least twice MAX_FUNCTIONS, so a probe sequence
+// always ends at an empty slot
+#define INDEX_SIZE (2 * MAX_FUNCTIONS)
+#define EMPTY_SLOT 0xFFFF
+
 
 typedef struct {
-    char name[10];
+    // 0-terminated
+    char name[MAX_NAME_LENGTH + 1];
+    unsigned int hash;
     void (*f)();
 } funcRef;
 
-int min(int x, int y) {
-    if (x < y) return x;
-    else return y;
+typedef struct {
+    funcRef refs[MAX_FUNCTIONS];
+    int count;
+    // number of the funcRef in refs, or EMPTY_SLOT
+    unsigned short index[INDEX_SIZE];
+} funcRegistry;
+
+static funcRegistry registry;
+
+
+void initRegistry() {
+    memset(&registry, 0, sizeof(registry));
+    memset(registry.index, 0xFF, sizeof(registry.index));
 }
 
-funcRef *initFuncRef(char* name, void(*g)()) {
-    int len = strlen(name);
-    funcRef *r = (funcRef*)calloc(1, sizeof(funcRef));
-    r->f = g;    
-    memcpy(r->name, name, min(10, len));    
-    return r;
+// FNV-1a
+unsigned int hashName(const char *name, int len) {
+    unsigned int h = 2166136261U;
+    int i;
+    for (i = 0; i < len; i++) {
+        h ^= (unsigned char)name[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+// Returns the slot that holds the name, or the empty slot where it
+// would be inserted.
+int findSlot(const char *name, int len, unsigned int hash) {
+    int slot = hash & (INDEX_SIZE - 1);
+    while (registry.index[slot] != EMPTY_SLOT) {
+        funcRef *r = &registry.refs[registry.index[slot]];
+        if (r->hash == hash && strncmp(r->name, name, len) == 0 && r->name[len] == 0) break;
+        slot = (slot + 1) & (INDEX_SIZE - 1);
+    }
+    return slot;
+}
+
+// Removes the entry in slot and moves later entries of the same probe
+// sequence back, so no tombstones are needed.
+void removeSlot(int slot) {
+    int next = slot;
+    while (1) {
+        int home;
+        next = (next + 1) & (INDEX_SIZE - 1);
+        if (registry.index[next] == EMPTY_SLOT) break;
+        home = registry.refs[registry.index[next]].hash & (INDEX_SIZE - 1);
+        // the entry may only move if slot lies between its home and next
+        if (((next - home) & (INDEX_SIZE - 1)) >= ((next - slot) & (INDEX_SIZE - 1))) {
+            registry.index[slot] = registry.index[next];
+            slot = next;
+        }
+    }
+    registry.index[slot] = EMPTY_SLOT;
+}
+
+// Returns the length of name, or -1 if it is empty or longer than
+// MAX_NAME_LENGTH. Reads at most MAX_NAME_LENGTH + 1 characters.
+int nameLength(const char *name) {
+    int len = 0;
+    while (len <= MAX_NAME_LENGTH && name[len] != 0) len++;
+    if (len == 0 || len > MAX_NAME_LENGTH) return -1;
+    return len;
 }
 
+// Returns NULL if the name is invalid or taken or the registry is full.
+funcRef *registerFunction(const char *name, void(*g)()) {
+    int len = nameLength(name);
+    unsigned int hash;
+    int slot;
+    funcRef *r;
 
+    if (len < 0 || registry.count >= MAX_FUNCTIONS) return NULL;
+    hash = hashName(name, len);
+    slot = findSlot(name, len, hash);
+    if (registry.index[slot] != EMPTY_SLOT) return NULL;
 
-void renameFuncRef(funcRef *ref) {
+    r = &registry.refs[registry.count];
+    memcpy(r->name, name, len);
+    r->name[len] = 0;
+    r->hash = hash;
+    r->f = g;
+    registry.index[slot] = registry.count++;
+    return r;
+}
+
+funcRef *lookupFunction(const char *name) {
+    int len = nameLength(name);
+    int slot;
+    if (len < 0) return NULL;
+    slot = findSlot(name, len, hashName(name, len));
+    if (registry.index[slot] == EMPTY_SLOT) return NULL;
+    return &registry.refs[registry.index[slot]];
+}
+
+// Reads a line of at most MAX_NAME_LENGTH characters into buffer,
+// which needs room for MAX_NAME_LENGTH + 1. The rest of a longer line
+// is skipped. Returns the length or -1 if the line was too long.
+int readName(char *buffer) {
     int i = 0;
-    char k = 0;
-    
+    int k = 0;
+    while ((k = getchar()) != EOF && k != '\n') {
+        if (i <= MAX_NAME_LENGTH) buffer[i] = k;
+        i++;
+    }
+    if (i > MAX_NAME_LENGTH) {
+        buffer[0] = 0;
+        return -1;
+    }
+    buffer[i] = 0;
+    return i;
+}
+
+
+
+// Returns 0 if the name was changed, otherwise the old name is kept.
+int renameFuncRef(funcRef *ref) {
+    char name[MAX_NAME_LENGTH + 1];
+    int len, slot;
+    unsigned int hash;
+
     printf("Neuen Funktionsnamen eingeben: ");
-    while (k != EOF && k != '\n') {
-        k = getchar();
-        if (k != EOF) {
-            ref->name[i] = k;
-            i++;
-        }
+    len = readName(name);
+    if (len <= 0) {
+        printf("ungueltiger Name, hoechstens %d Zeichen\n", MAX_NAME_LENGTH);
+        return -1;
     }
-    ref->name[i] = 0;
+    hash = hashName(name, len);
+    if (registry.index[findSlot(name, len, hash)] != EMPTY_SLOT) {
+        printf("der Name %s ist schon vergeben\n", name);
+        return -1;
+    }
+
+    removeSlot(findSlot(ref->name, strlen(ref->name), ref->hash));
+    memcpy(ref->name, name, len + 1);
+    ref->hash = hash;
+    slot = findSlot(ref->name, len, hash);
+    registry.index[slot] = ref - registry.refs;
+    return 0;
 }
 
 
 
 void good() {
-    printf("i am good\n"); 
-    getchar();   
+    printf("i am good\n");
+    getchar();
 }
 
 void evil() {
     printf("i am evil\n");
-    getchar();   
+    getchar();
 }
 
 
 int main() {
-    funcRef *ref = initFuncRef("spass", good);
+    funcRef *ref;
+    initRegistry();
+    ref = registerFunction("spass", good);
+    registerFunction("boese", evil);
     renameFuncRef(ref);
     printf("neuer name: %s\n", ref->name);
-    ref->f();
+    lookupFunction(ref->name)->f();
     return 0;
-}
\ No newline at end of file
+}